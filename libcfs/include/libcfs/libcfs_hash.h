@@ -204,6 +204,12 @@ enum cfs_hash_tag {
          * change on hash table is non-blocking
          */
         CFS_HASH_NBLK_CHANGE    = 1 << 13,
+        /**
+         * hlist can be walked under rcu_read_lock() by
+         * cfs_hash_bd_lookup_rcu(), items must be freed after a grace
+         * period, see cfs_hash_bd_lookup_rcu()
+         */
+        CFS_HASH_RCU            = 1 << 14,
         /** NB, we typed hs_flags as  __u16, please change it
          * if you need to extend >=16 flags */
 };
@@ -471,6 +477,12 @@ cfs_hash_with_nblk_change(cfs_hash_t *hs)
         return (hs->hs_flags & CFS_HASH_NBLK_CHANGE) != 0;
 }
 
+static inline int
+cfs_hash_with_rcu(cfs_hash_t *hs)
+{
+        return (hs->hs_flags & CFS_HASH_RCU) != 0;
+}
+
 static inline int
 cfs_hash_is_exiting(cfs_hash_t *hs)
 {       /* cfs_hash_destroy is called */
@@ -686,6 +698,8 @@ struct hlist_node *cfs_hash_bd_findadd_locked(cfs_hash_t *hs, cfs_hash_bd_t *bd,
 struct hlist_node *cfs_hash_bd_finddel_locked(cfs_hash_t *hs, cfs_hash_bd_t *bd,
 						const void *key,
 						struct hlist_node *hnode);
+struct hlist_node *cfs_hash_bd_lookup_rcu(cfs_hash_t *hs, cfs_hash_bd_t *bd,
+					  const void *key);
 
 /**
  * operations on cfs_hash bucket (bd: bucket descriptor),
@@ -266,7 +266,10 @@ static int
 cfs_hash_hh_hnode_add(cfs_hash_t *hs, cfs_hash_bd_t *bd,
 		      struct hlist_node *hnode)
 {
-	hlist_add_head(hnode, cfs_hash_hh_hhead(hs, bd));
+	if (cfs_hash_with_rcu(hs))
+		hlist_add_head_rcu(hnode, cfs_hash_hh_hhead(hs, bd));
+	else
+		hlist_add_head(hnode, cfs_hash_hh_hhead(hs, bd));
 	return -1; /* unknown depth */
 }
 
@@ -274,7 +277,10 @@ static int
 cfs_hash_hh_hnode_del(cfs_hash_t *hs, cfs_hash_bd_t *bd,
 		      struct hlist_node *hnode)
 {
-	hlist_del_init(hnode);
+	if (cfs_hash_with_rcu(hs))
+		hlist_del_init_rcu(hnode);
+	else
+		hlist_del_init(hnode);
 	return -1; /* unknown depth */
 }
 
@@ -308,7 +314,10 @@ cfs_hash_hd_hnode_add(cfs_hash_t *hs, cfs_hash_bd_t *bd,
 {
 	cfs_hash_head_dep_t *hh = container_of(cfs_hash_hd_hhead(hs, bd),
 					       cfs_hash_head_dep_t, hd_head);
-	hlist_add_head(hnode, &hh->hd_head);
+	if (cfs_hash_with_rcu(hs))
+		hlist_add_head_rcu(hnode, &hh->hd_head);
+	else
+		hlist_add_head(hnode, &hh->hd_head);
 	return ++hh->hd_depth;
 }
 
@@ -318,7 +327,10 @@ cfs_hash_hd_hnode_del(cfs_hash_t *hs, cfs_hash_bd_t *bd,
 {
 	cfs_hash_head_dep_t *hh = container_of(cfs_hash_hd_hhead(hs, bd),
 					       cfs_hash_head_dep_t, hd_head);
-	hlist_del_init(hnode);
+	if (cfs_hash_with_rcu(hs))
+		hlist_del_init_rcu(hnode);
+	else
+		hlist_del_init(hnode);
 	return --hh->hd_depth;
 }
 
@@ -697,6 +709,35 @@ cfs_hash_bd_finddel_locked(cfs_hash_t *hs, cfs_hash_bd_t *bd,
 }
 EXPORT_SYMBOL(cfs_hash_bd_finddel_locked);
 
+/**
+ * Lockless lookup in bucket \a bd of a hash created with CFS_HASH_RCU, the
+ * caller must hold rcu_read_lock().
+ *
+ * No reference is taken on the returned item, and it can be on its way out
+ * of the hash: the caller has to take its reference in a way that fails for
+ * a dying item (e.g. atomic_inc_not_zero()), and fall back to the locked
+ * lookup on failure. An item added or removed concurrently may be missed as
+ * well. Items must not be freed before an RCU grace period has elapsed
+ * after their removal from the hash.
+ */
+struct hlist_node *
+cfs_hash_bd_lookup_rcu(cfs_hash_t *hs, cfs_hash_bd_t *bd, const void *key)
+{
+	struct hlist_head *hhead = cfs_hash_bd_hhead(hs, bd);
+	struct hlist_node *hnode;
+
+	LASSERT(cfs_hash_with_rcu(hs));
+
+	for (hnode = rcu_dereference(hhead->first); hnode != NULL;
+	     hnode = rcu_dereference(hnode->next)) {
+		if (cfs_hash_keycmp(hs, key, hnode))
+			return hnode;
+	}
+
+	return NULL;
+}
+EXPORT_SYMBOL(cfs_hash_bd_lookup_rcu);
+
 static void
 cfs_hash_multi_bd_lock(cfs_hash_t *hs, cfs_hash_bd_t *bds,
                        unsigned n, int excl)
@@ -1053,6 +1094,10 @@ cfs_hash_create(char *name, unsigned cur_bits, unsigned max_bits,
                      (flags & CFS_HASH_NO_LOCK) == 0));
         LASSERT(ergo((flags & CFS_HASH_REHASH_KEY) != 0,
                       ops->hs_keycpy != NULL));
+	/* only the hlists adding at head publish items with RCU, and items
+	 * must not move between buckets under lockless readers */
+	LASSERT(ergo((flags & CFS_HASH_RCU) != 0,
+		     (flags & (CFS_HASH_ADD_TAIL | CFS_HASH_REHASH)) == 0));
 
         len = (flags & CFS_HASH_BIGNAME) == 0 ?
               CFS_HASH_NAME_LEN : CFS_HASH_BIGNAME_LEN;
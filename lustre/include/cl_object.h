@@ -728,6 +728,11 @@ struct cl_page {
          * creation.
          */
         enum cl_page_type        cp_type;
+	/**
+	 * Slab cache the page was allocated from, -1 for kmalloc. Immutable
+	 * after creation.
+	 */
+	int			 cp_kmem_index;
 
         /**
          * Owning IO in cl_page_state::CPS_OWNED state. Sub-page can be owned
@@ -1730,10 +1735,15 @@ enum cl_enq_flags {
 	 * enqueue a lock to test DLM lock existence.
 	 */
 	CEF_PEEK	= 0x00000040,
+	/**
+	 * tell the server not to expand the extent of the lock beyond the
+	 * requested one; used by lock ahead requests.
+	 */
+	CEF_LOCK_NO_EXPAND = 0x00000080,
 	/**
 	 * mask of enq_flags.
 	 */
-	CEF_MASK         = 0x0000007f,
+	CEF_MASK         = 0x000000ff,
 };
 
 /**
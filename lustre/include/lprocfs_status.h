@@ -213,6 +213,21 @@ struct lprocfs_stats {
 	struct lprocfs_percpu		*ls_percpu[0];
 };
 
+/**
+ * Set of log2 histograms, \a lhs_width histograms of OBD_HIST_MAX buckets
+ * for each of \a lhs_num indices (e.g. one per RPC opcode).
+ *
+ * Buckets are kept per CPU and tallied without locking; both the per-CPU
+ * index array and the buckets of each index are only allocated the first
+ * time a value is tallied for them, so that sparse sets stay small.
+ */
+struct lprocfs_hist_set {
+	unsigned short			lhs_num;
+	unsigned short			lhs_width;
+	/* per-CPU array of lhs_num pointers to lhs_width * OBD_HIST_MAX */
+	__u32				**lhs_percpu[0];
+};
+
 #define OPC_RANGE(seg) (seg ## _LAST_OPC - seg ## _FIRST_OPC)
 
 /* Pack all opcodes down into a single monotonically increasing index */
@@ -743,6 +758,15 @@ void lprocfs_oh_tally_log2(struct obd_histogram *oh, unsigned int value);
 void lprocfs_oh_clear(struct obd_histogram *oh);
 unsigned long lprocfs_oh_sum(struct obd_histogram *oh);
 
+struct lprocfs_hist_set *lprocfs_hist_alloc(unsigned int num,
+					    unsigned int width);
+void lprocfs_hist_free(struct lprocfs_hist_set **seth);
+void lprocfs_hist_tally_log2(struct lprocfs_hist_set *set, int idx, int hist,
+			     unsigned long value);
+unsigned long lprocfs_hist_sum(struct lprocfs_hist_set *set, int idx, int hist,
+			       unsigned long *buckets);
+void lprocfs_hist_clear(struct lprocfs_hist_set *set);
+
 void lprocfs_stats_collect(struct lprocfs_stats *stats, int idx,
                            struct lprocfs_counter *cnt);
 
@@ -1137,6 +1161,24 @@ static inline
 unsigned long lprocfs_oh_sum(struct obd_histogram *oh)
 { return 0; }
 static inline
+struct lprocfs_hist_set *lprocfs_hist_alloc(unsigned int num,
+					    unsigned int width)
+{ return NULL; }
+static inline
+void lprocfs_hist_free(struct lprocfs_hist_set **seth)
+{ return; }
+static inline
+void lprocfs_hist_tally_log2(struct lprocfs_hist_set *set, int idx, int hist,
+			     unsigned long value)
+{ return; }
+static inline
+unsigned long lprocfs_hist_sum(struct lprocfs_hist_set *set, int idx, int hist,
+			       unsigned long *buckets)
+{ return 0; }
+static inline
+void lprocfs_hist_clear(struct lprocfs_hist_set *set)
+{ return; }
+static inline
 void lprocfs_stats_collect(struct lprocfs_stats *stats, int idx,
                            struct lprocfs_counter *cnt)
 { return; }
@@ -277,6 +277,7 @@ struct ost_id {
 #define LL_IOC_MIGRATE			_IOR('f', 247, int)
 #define LL_IOC_FID2MDTIDX		_IOWR('f', 248, struct lu_fid)
 #define LL_IOC_GETPARENT		_IOWR('f', 249, struct getparent)
+#define LL_IOC_LOCK_AHEAD		_IOWR('f', 250, struct llapi_lock_ahead_arg)
 
 /* Lease types for use as arg and return of LL_IOC_{GET,SET}_LEASE ioctl. */
 enum ll_lease_type {
@@ -1025,6 +1026,32 @@ struct ioc_data_version {
 #define LL_DV_RD_FLUSH (1 << 0) /* Flush dirty pages from clients */
 #define LL_DV_WR_FLUSH (1 << 1) /* Flush all caching pages from clients */
 
+/* Lock ahead: request extent locks from the servers without doing any I/O,
+ * so that writers of disjoint regions of a shared file do not have their
+ * locks expanded into each other's region. See LL_IOC_LOCK_AHEAD. */
+#define LLAPI_LOCK_AHEAD_V1		1
+#define LLAPI_LOCK_AHEAD_MAX_EXTENTS	1024
+
+enum llapi_lock_mode {
+	LLAPI_LOCK_MODE_READ	= 1,
+	LLAPI_LOCK_MODE_WRITE	= 2,
+};
+
+struct llapi_lock_ahead_extent {
+	__u64	lle_start;	/* first byte of the extent */
+	__u64	lle_end;	/* last byte of the extent, inclusive */
+	__s32	lle_result;	/* 0 if granted, negative errno otherwise */
+	__u32	lle_padding;
+};
+
+struct llapi_lock_ahead_arg {
+	__u32	lla_version;	/* LLAPI_LOCK_AHEAD_V1 */
+	__u32	lla_lock_mode;	/* enum llapi_lock_mode */
+	__u32	lla_extent_count;
+	__u32	lla_padding;
+	struct llapi_lock_ahead_extent lla_extents[0];
+};
+
 #ifndef offsetof
 #define offsetof(typ, memb)     ((unsigned long)((char *)&(((typ *)0)->memb)))
 #endif
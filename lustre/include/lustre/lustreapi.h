@@ -398,6 +398,7 @@ extern int llapi_lease_put(int fd);
 /* Group lock */
 int llapi_group_lock(int fd, int gid);
 int llapi_group_unlock(int fd, int gid);
+int llapi_lock_ahead(int fd, struct llapi_lock_ahead_arg *lla);
 
 /** @} llapi */
 
@@ -64,6 +64,7 @@ struct obd_device;
 
 #define LDLM_DEFAULT_LRU_SIZE (100 * num_online_cpus())
 #define LDLM_DEFAULT_MAX_ALIVE (cfs_time_seconds(36000))
+#define LDLM_DEFAULT_LRU_REUSE_MAX (2)
 #define LDLM_CTIME_AGE_LIMIT (10)
 #define LDLM_DEFAULT_PARALLEL_AST_LIMIT 1024
 
@@ -242,6 +243,12 @@ struct ldlm_pool {
 	atomic_t		pl_limit;
 	/** Number of granted locks in */
 	atomic_t		pl_granted;
+	/** Memory pinned by granted locks, their resources and interval
+	 *  nodes, in bytes, server side only. */
+	atomic_long_t		pl_granted_bytes;
+	/** Recalculate SLV against the memory used by granted locks and
+	 *  the memory left on the server rather than the lock count. */
+	atomic_t		pl_mem_aware;
 	/** Grant rate per T. */
 	atomic_t		pl_grant_rate;
 	/** Cancel rate per T. */
@@ -424,6 +431,12 @@ struct ldlm_namespace {
 	unsigned int		ns_max_unused;
 	/** Maximum allowed age (last used time) for locks in the LRU */
 	unsigned int		ns_max_age;
+	/**
+	 * Maximum number of reuses counted for a lock in the LRU. Each one
+	 * lets the lock survive one more LRU aging pass, so that locks used
+	 * only once are canceled before the frequently reused ones.
+	 */
+	unsigned int		ns_lru_reuse_max;
 	/**
 	 * Server only: number of times we evicted clients due to lack of reply
 	 * to ASTs.
@@ -802,6 +815,12 @@ struct ldlm_lock {
 	 */
 	cfs_time_t		l_last_used;
 
+	/**
+	 * Number of times the lock was taken back from the LRU, capped by
+	 * ns_lru_reuse_max. Protected by ns_lock.
+	 */
+	unsigned int		l_lru_reuse;
+
 	/** Originally requested extent for the extent lock. */
 	struct ldlm_extent	l_req_extent;
 
@@ -962,6 +981,11 @@ struct ldlm_resource {
 	bool			lr_lvb_initialized;
 	/** protected by lr_lock */
 	void			*lr_lvb_data;
+	/**
+	 * Bytes charged to the lock pool for this resource while it has
+	 * granted locks, see ldlm_pool_add(). Protected by lr_lock.
+	 */
+	long			lr_pool_mem;
 
 	/** When the resource was considered as contended. */
 	cfs_time_t		lr_contention_time;
@@ -969,6 +993,8 @@ struct ldlm_resource {
 	struct lu_ref		lr_reference;
 
 	struct inode		*lr_lvb_inode;
+	/** resource is freed after a grace period, see ldlm_resource_get() */
+	struct rcu_head		lr_rcu;
 };
 
 static inline bool ldlm_has_layout(struct ldlm_lock *lock)
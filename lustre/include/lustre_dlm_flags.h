@@ -35,7 +35,7 @@
 #ifndef LDLM_ALL_FLAGS_MASK
 
 /** l_flags bits marked as "all_flags" bits */
-#define LDLM_FL_ALL_FLAGS_MASK          0x00FFFFFFC08F932FULL
+#define LDLM_FL_ALL_FLAGS_MASK          0x00FFFFFFC09F932FULL
 
 /** extent, mode, or resource changed */
 #define LDLM_FL_LOCK_CHANGED            0x0000000000000001ULL // bit   0
@@ -125,6 +125,14 @@
 #define ldlm_set_test_lock(_l)          LDLM_SET_FLAG((  _l), 1ULL << 19)
 #define ldlm_clear_test_lock(_l)        LDLM_CLEAR_FLAG((_l), 1ULL << 19)
 
+/**
+ * Do not expand this lock.  Grant it only on the extent requested.  Used
+ * for locks requested ahead of I/O by the client (LL_IOC_LOCK_AHEAD). */
+#define LDLM_FL_NO_EXPANSION            0x0000000000100000ULL // bit  20
+#define ldlm_is_no_expansion(_l)        LDLM_TEST_FLAG(( _l), 1ULL << 20)
+#define ldlm_set_no_expansion(_l)       LDLM_SET_FLAG((  _l), 1ULL << 20)
+#define ldlm_clear_no_expansion(_l)     LDLM_CLEAR_FLAG((_l), 1ULL << 20)
+
 /**
  * Immediatelly cancel such locks when they block some other locks. Send
  * cancel notification to original lock holder, but expect no reply. This
@@ -368,9 +376,11 @@
 /* Flags inherited from wire on enqueue/reply between client/server. */
 /* NO_TIMEOUT flag to force ldlm_lock_match() to wait with no timeout. */
 /* TEST_LOCK flag to not let TEST lock to be granted. */
+/* NO_EXPANSION to tell the server not to expand the extent of the lock. */
 #define LDLM_FL_INHERIT_MASK            (LDLM_FL_CANCEL_ON_BLOCK	|\
 					 LDLM_FL_NO_TIMEOUT		|\
-					 LDLM_FL_TEST_LOCK)
+					 LDLM_FL_TEST_LOCK		|\
+					 LDLM_FL_NO_EXPANSION)
 
 /** flags returned in @flags parameter on ldlm_lock_enqueue,
  * to be re-constructed on re-send */
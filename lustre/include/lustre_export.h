@@ -146,6 +146,15 @@ enum obd_option {
         OBD_OPT_ABORT_RECOV =   0x0004,
 };
 
+/**
+ * # of buckets of obd_export::exp_reply_hash. Difficult replies stay on the
+ * export until their transaction commits, so a busy client can have
+ * hundreds of them outstanding, not only its RPCs in flight. 256 buckets
+ * keep resend lookups short for that many at 2KB per export.
+ */
+#define EXP_REPLY_HASH_BITS	8
+#define EXP_REPLY_HASH_SIZE	(1 << EXP_REPLY_HASH_BITS)
+
 /**
  * Export structure. Represents target-side of connection in portals.
  * Also used in Lustre to connect between layers on the same node when
@@ -209,6 +218,8 @@ struct obd_export {
 	 */
 	cfs_hash_t	       *exp_flock_hash;
 	struct list_head	exp_outstanding_replies;
+	/** exp_outstanding_replies indexed by XID */
+	struct hlist_head	exp_reply_hash[EXP_REPLY_HASH_SIZE];
 	struct list_head	exp_uncommitted_replies;
 	spinlock_t		exp_uncommitted_replies_lock;
 	/** Last committed transno for this export */
@@ -218,7 +229,7 @@ struct obd_export {
 	/** On replay all requests waiting for replay are linked here */
 	struct list_head	exp_req_replay_queue;
 	/**
-	 * protects exp_flags, exp_outstanding_replies and the change
+	 * protects exp_flags, exp_outstanding_replies, exp_reply_hash and the change
 	 * of exp_imp_reverse
 	 */
 	spinlock_t		  exp_lock;
@@ -313,6 +324,18 @@ static inline int exp_connect_cancelset(struct obd_export *exp)
 	return !!(exp_connect_flags(exp) & OBD_CONNECT_CANCELSET);
 }
 
+static inline int exp_connect_bl_batch(struct obd_export *exp)
+{
+	LASSERT(exp != NULL);
+	return !!(exp_connect_flags(exp) & OBD_CONNECT_BL_BATCH);
+}
+
+static inline int exp_connect_lockahead(struct obd_export *exp)
+{
+	LASSERT(exp != NULL);
+	return !!(exp_connect_flags(exp) & OBD_CONNECT_LOCKAHEAD);
+}
+
 static inline int exp_connect_lru_resize(struct obd_export *exp)
 {
 	LASSERT(exp != NULL);
@@ -121,6 +121,12 @@
 
 #define PTLRPC_NTHRS_INIT	2
 
+/**
+ * Seconds a service thread above the initial thread count may stay idle
+ * before it exits, when thread autoscaling is enabled
+ */
+#define PTLRPC_THR_IDLE_TIMEOUT	60
+
 /**
  * Buffer Constants
  *
@@ -647,6 +653,8 @@ struct ptlrpc_reply_state {
 	struct list_head	rs_list;
 	/** Linkage for list of all reply states on same export */
 	struct list_head	rs_exp_list;
+	/** Linkage into obd_export::exp_reply_hash, by rs_xid */
+	struct hlist_node	rs_xid_hash;
 	/** Linkage for list of all reply states for same obd */
 	struct list_head	rs_obd_list;
 #if RS_DEBUG
@@ -663,6 +671,7 @@ struct ptlrpc_reply_state {
         unsigned long          rs_handled:1;  /* been handled yet? */
         unsigned long          rs_on_net:1;   /* reply_out_callback pending? */
         unsigned long          rs_prealloc:1; /* rs from prealloc list */
+	unsigned long	       rs_recycle:1;  /* rs from recycle list */
         unsigned long          rs_committed:1;/* the transaction was committed
                                                  and the rs was dispatched
                                                  by ptlrpc_commit_replies */
@@ -1103,6 +1112,11 @@ struct ptlrpc_nrs {
 	 * NRS policy is throttling reqeust
 	 */
 	unsigned			nrs_throttling:1;
+	/**
+	 * Lock-free enqueue ring for the FIFO fast path; only allocated on
+	 * regular NRS heads, and may be NULL if disabled.
+	 */
+	struct nrs_fifo_ring	       *nrs_fifo_ring;
 };
 
 #define NRS_POL_NAME_MAX		16
@@ -1422,6 +1436,45 @@ struct nrs_fifo_req {
 	__u64			fr_sequence;
 };
 
+/**
+ * Slot of an nrs_fifo_ring; \e rs_seq tells producers and consumers whether
+ * the slot is free or holds a request for the current lap of the ring.
+ */
+struct nrs_fifo_ring_slot {
+	unsigned long			 rs_seq;
+	struct ptlrpc_nrs_request	*rs_nrq;
+};
+
+/**
+ * Bounded lock-free MPMC ring of requests, one per regular NRS head, i.e. one
+ * per CPT partition of a service.
+ *
+ * While the FIFO policy is the only policy started on the NRS head, incoming
+ * requests are pushed to the ring without taking
+ * ptlrpc_service_part::scp_req_lock; they are moved into the NRS policies in
+ * batches by the next service thread that takes the lock to fetch a request.
+ * If the ring is full, or any other policy is started or being started, the
+ * regular locked enqueue path is used instead.
+ */
+struct nrs_fifo_ring {
+	/** Next slot to be filled by a producer. */
+	unsigned long			 fr_head ____cacheline_aligned;
+	/** Next slot to be drained by a consumer. */
+	unsigned long			 fr_tail ____cacheline_aligned;
+	/** Number of slots minus one; the ring size is a power of two. */
+	unsigned long			 fr_mask;
+	/**
+	 * Statistics, protected by ptlrpc_service_part::scp_req_lock.
+	 */
+	/** # requests enqueued without taking scp_req_lock. */
+	__u64				 fr_nfast;
+	/** # times requests were moved from the ring into the NRS head. */
+	__u64				 fr_nbatch;
+	/** # requests that used the locked path as the ring was full. */
+	__u64				 fr_nfull;
+	struct nrs_fifo_ring_slot	 fr_slots[0];
+};
+
 /** @} fifo */
 
 /**
@@ -1695,6 +1748,7 @@ struct nrs_orr_req {
 /** @} ORR/TRR */
 
 #include <lustre_nrs_tbf.h>
+#include <lustre_nrs_drr.h>
 
 /**
  * NRS request
@@ -1741,6 +1795,10 @@ struct ptlrpc_nrs_request {
 		 * TBF request definition
 		 */
 		struct nrs_tbf_req	tbf;
+		/**
+		 * DRR request definition
+		 */
+		struct nrs_drr_req	drr;
 	} nr_u;
 	/**
 	 * Externally-registering policies may want to use this to allocate
@@ -2546,6 +2604,38 @@ struct ptlrpc_service_ops {
  */
 #define PTLRPC_SVC_HP_RATIO 10
 
+/**
+ * How many requests with the same opcode a service thread may handle back to
+ * back, without going through its event loop in between
+ */
+#define PTLRPC_SVC_BATCH_MAX 8
+
+/**
+ * Average time requests may wait in the NRS heads before more service threads
+ * are started, in microseconds
+ */
+#define PTLRPC_SVC_QWAIT_TARGET 10000
+
+/**
+ * Max # of freed request structures and reply states each service partition
+ * keeps for reuse, so that steady-state request handling does not go back to
+ * the allocator
+ */
+#define PTLRPC_SVC_RECYCLE_MAX 128
+
+/**
+ * Latency histograms kept per opcode for each service, in usec.
+ */
+enum ptlrpc_latency_hist {
+	/** request arrival to start of handling */
+	PTLRPC_LAT_QUEUE_WAIT	= 0,
+	/** handling by the service thread */
+	PTLRPC_LAT_SERVICE,
+	/** packing and submitting the reply to LNet */
+	PTLRPC_LAT_REPLY_SEND,
+	PTLRPC_LAT_LAST
+};
+
 /**
  * Definition of PortalRPC service.
  * The service is listening on a particular portal (like tcp port)
@@ -2574,12 +2664,26 @@ struct ptlrpc_service {
 	struct proc_dir_entry           *srv_procroot;
         /** Pointer to statistic data for this service */
         struct lprocfs_stats           *srv_stats;
+	/** per-opcode latency histograms, see enum ptlrpc_latency_hist */
+	struct lprocfs_hist_set		*srv_latency_hist;
         /** # hp per lp reqs to handle */
         int                             srv_hpreq_ratio;
+	/** max # reqs of the same opcode a thread handles per wakeup */
+	int				srv_batch_max;
+	/**
+	 * target average queue wait for thread autoscaling, in usec;
+	 * 0 disables autoscaling
+	 */
+	int				srv_qwait_target;
         /** biggest request to receive */
         int                             srv_max_req_size;
         /** biggest reply to send */
         int                             srv_max_reply_size;
+	/**
+	 * size of the reply states kept for reuse, covering all replies with
+	 * only fixed-size fields; 0 disables reply state recycling
+	 */
+	int				srv_rs_recycle_size;
         /** size of individual buffers */
         int                             srv_buf_size;
         /** # buffers to allocate in 1 group */
@@ -2664,6 +2768,10 @@ struct ptlrpc_service_part {
 	int				scp_nreqs_incoming;
 	/** request buffers to be reposted */
 	struct list_head		scp_rqbd_idle;
+	/** zeroed request structures for reuse by incoming requests */
+	struct list_head		scp_req_free;
+	/** # requests in scp_req_free */
+	int				scp_nreqs_free;
 	/** req buffers receiving */
 	struct list_head		scp_rqbd_posted;
 	/** incoming reqs */
@@ -2699,6 +2807,8 @@ struct ptlrpc_service_part {
 	int				scp_nhreqs_active;
 	/** # hp requests handled */
 	int				scp_hreq_count;
+	/** moving average of the time reqs wait in the NRS heads, in usec */
+	long				scp_qwait_avg;
 
 	/** NRS head for regular requests */
 	struct ptlrpc_nrs		scp_nrs_reg;
@@ -2736,6 +2846,10 @@ struct ptlrpc_service_part {
 	struct list_head		scp_rep_idle;
 	/** waitq to run, when adding stuff to srv_free_rs_list */
 	wait_queue_head_t		scp_rep_waitq;
+	/** reply states of srv_rs_recycle_size for reuse */
+	struct list_head		scp_rep_free;
+	/** # reply states in scp_rep_free */
+	int				scp_nreps_free;
 	/** # 'difficult' replies */
 	atomic_t			scp_nreps_difficult;
 };
@@ -2794,6 +2908,27 @@ struct ptlrpcd_ctl {
          * Record the partner index to be processed next.
          */
         int                         pc_cursor;
+	/**
+	 * NUMA node of the CPU the ptlrpcd thread is associated with, used to
+	 * prefer near peers when stealing work.
+	 */
+	int				pc_node;
+	/**
+	 * The thread had nothing to do last time it checked its set, and
+	 * may be woken up to steal work from overloaded peers.
+	 */
+	int				pc_idle;
+	/**
+	 * Async RPCs taken over from partners and from other peers; only
+	 * updated by the thread itself.
+	 */
+	__u64				pc_steal_partner;
+	__u64				pc_steal_peer;
+	/**
+	 * Async RPCs taken away by other ptlrpcd threads, protected by
+	 * pc_lock.
+	 */
+	__u64				pc_stolen;
 };
 
 /* Bits for pc_flags */
@@ -3405,6 +3540,49 @@ ptlrpc_rs_decref(struct ptlrpc_reply_state *rs)
 		lustre_free_reply_state(rs);
 }
 
+/**
+ * Add difficult reply \a rs to the outstanding replies of \a exp.
+ * Called with exp_lock held.
+ */
+static inline void
+ptlrpc_rs_exp_add(struct obd_export *exp, struct ptlrpc_reply_state *rs)
+{
+	list_add_tail(&rs->rs_exp_list, &exp->exp_outstanding_replies);
+	hlist_add_head(&rs->rs_xid_hash,
+		       &exp->exp_reply_hash[rs->rs_xid &
+					    (EXP_REPLY_HASH_SIZE - 1)]);
+}
+
+/**
+ * Remove \a rs from the outstanding replies of its export, noop if removed
+ * already. Called with exp_lock held.
+ */
+static inline void ptlrpc_rs_exp_del(struct ptlrpc_reply_state *rs)
+{
+	list_del_init(&rs->rs_exp_list);
+	if (!hlist_unhashed(&rs->rs_xid_hash))
+		hlist_del_init(&rs->rs_xid_hash);
+}
+
+/**
+ * Find the outstanding reply of \a exp to the request with \a xid, i.e. the
+ * reply to the original of a resent request. Called with exp_lock held.
+ */
+static inline struct ptlrpc_reply_state *
+ptlrpc_rs_exp_find(struct obd_export *exp, __u64 xid)
+{
+	struct ptlrpc_reply_state *rs;
+	struct hlist_node	  *node;
+
+	cfs_hlist_for_each_entry(rs, node, &exp->exp_reply_hash[xid &
+				 (EXP_REPLY_HASH_SIZE - 1)], rs_xid_hash) {
+		if (rs->rs_xid == xid)
+			return rs;
+	}
+
+	return NULL;
+}
+
 /* Should only be called once per req */
 static inline void ptlrpc_req_drop_rs(struct ptlrpc_request *req)
 {
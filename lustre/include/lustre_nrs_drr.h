@@ -0,0 +1,141 @@
+/*
+ * GPL HEADER START
+ *
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 only,
+ * as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License version 2 for more details.  A copy is
+ * included in the COPYING file that accompanied this code.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * GPL HEADER END
+ */
+/*
+ * Copyright (c) 2014, Intel Corporation.
+ */
+/*
+ *
+ * Network Request Scheduler (NRS) Deficit Round Robin (DRR) policy
+ *
+ */
+
+#ifndef _LUSTRE_NRS_DRR_H
+#define _LUSTRE_NRS_DRR_H
+#include <lustre_net.h>
+
+/* \name drr
+ *
+ * DRR policy, Deficit Round Robin over estimated request service cost
+ *
+ * @{
+ */
+
+#define NRS_DRR_TYPE_NID	"nid"
+#define NRS_DRR_TYPE_JOBID	"jobid"
+#define NRS_DRR_TYPE_MAX_LEN	20
+
+/**
+ * Key of a DRR client; only one of the fields is in use, depending on the
+ * type the policy instance has been started with.
+ */
+struct nrs_drr_key {
+	lnet_nid_t			dk_nid;
+	char				dk_jobid[LUSTRE_JOBID_SIZE];
+};
+
+/**
+ * Private data structure for the DRR policy
+ */
+struct nrs_drr_head {
+	/** Resource object for policy instance. */
+	struct ptlrpc_nrs_resource	dh_res;
+	/** Hash of clients, by nrs_drr_key. */
+	cfs_hash_t		       *dh_cli_hash;
+	/**
+	 * Clients with queued requests, in round robin order; the client at
+	 * the head of the list is the one being served.
+	 */
+	struct list_head		dh_active;
+	/** Sequence of requests, for debugging. */
+	__u64				dh_sequence;
+	/** Schedule by JobID instead of client NID. */
+	bool				dh_jobid;
+	/**
+	 * Cost credited to each active client per round, in KiB.
+	 */
+	__u16				dh_quantum;
+	/**
+	 * Fixed cost charged to every request, in bytes, on top of the bulk
+	 * bytes moved; reflects the per-RPC handling overhead.
+	 */
+	__u32				dh_rpc_cost;
+};
+
+/**
+ * Object representing a client (NID or JobID) in DRR
+ */
+struct nrs_drr_client {
+	/** Resource object for policy instance. */
+	struct ptlrpc_nrs_resource	dc_res;
+	/** Node in the hash table. */
+	struct hlist_node		dc_hnode;
+	/** Key of the client. */
+	struct nrs_drr_key		dc_key;
+	/**
+	 * Reference count; protected by the bucket lock of
+	 * nrs_drr_head::dh_cli_hash.
+	 */
+	long				dc_ref;
+	/** List of queued requests, in arrival order. */
+	struct list_head		dc_list;
+	/** Linkage into nrs_drr_head::dh_active. */
+	struct list_head		dc_active;
+	/** Cost the client is still allowed to use in this round. */
+	__u64				dc_deficit;
+};
+
+/**
+ * DRR NRS request definition
+ */
+struct nrs_drr_req {
+	/** Linkage to nrs_drr_client::dc_list. */
+	struct list_head		dr_list;
+	/** Estimated service cost of the request, in bytes. */
+	__u64				dr_cost;
+	/** Sequence of the request. */
+	__u64				dr_sequence;
+};
+
+/**
+ * DRR policy operations.
+ */
+enum nrs_ctl_drr {
+	/**
+	 * Read the round quantum of a DRR policy.
+	 */
+	NRS_CTL_DRR_RD_QUANTUM = PTLRPC_NRS_CTL_1ST_POL_SPEC,
+	/**
+	 * Write the round quantum of a DRR policy.
+	 */
+	NRS_CTL_DRR_WR_QUANTUM,
+	/**
+	 * Read the fixed per-RPC cost of a DRR policy.
+	 */
+	NRS_CTL_DRR_RD_RPC_COST,
+	/**
+	 * Write the fixed per-RPC cost of a DRR policy.
+	 */
+	NRS_CTL_DRR_WR_RPC_COST,
+};
+
+/** @} drr */
+#endif
@@ -125,8 +125,28 @@ struct nrs_tbf_rule {
 	atomic_t			 tr_ref;
 	/** Generation of the rule. */
 	__u64				 tr_generation;
+	/**
+	 * Parent rule in the hierarchy, or NULL for a top-level rule. A
+	 * reference is held on the parent for the lifetime of the rule.
+	 */
+	struct nrs_tbf_rule		*tr_parent;
+	/** Number of started rules that have this rule as parent. */
+	atomic_t			 tr_nchildren;
+	/**
+	 * Tokens left in the class bucket shared by all clients of this
+	 * rule and of its descendants; protected by the service partition
+	 * request lock.
+	 */
+	__u64				 tr_ntoken;
+	/** Time check-point of the class bucket. */
+	__u64				 tr_check_time;
+	/** Number of RPCs dispatched on tokens borrowed from ancestors. */
+	__u64				 tr_nborrowed;
 };
 
+/** Maximum depth of the TBF rule hierarchy, e.g. project/user/job. */
+#define NRS_TBF_RULE_DEPTH_MAX	(3)
+
 struct nrs_tbf_ops {
 	char *o_name;
 	int (*o_startup)(struct ptlrpc_nrs_policy *, struct nrs_tbf_head *);
@@ -235,6 +255,7 @@ struct nrs_tbf_cmd {
 	char			*tc_nids_str;
 	struct list_head	 tc_jobids;
 	char			*tc_jobids_str;
+	char			*tc_parent_name;
 	__u32			 tc_valid_types;
 	__u32			 tc_rule_flags;
 };
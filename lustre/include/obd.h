@@ -207,6 +207,13 @@ enum {
 
 struct mdc_rpc_lock;
 struct obd_import;
+/* a per-CPT partition of the page LRU of a client_obd */
+struct cl_lru_part {
+	spinlock_t		 clp_lock;	/* protects fields below */
+	struct list_head	 clp_list;	/* lru page list */
+	long			 clp_nr;	/* pages in clp_list */
+};
+
 struct client_obd {
 	struct rw_semaphore	 cl_sem;
         struct obd_uuid          cl_target_uuid;
@@ -269,11 +276,26 @@ struct client_obd {
 	struct list_head	cl_loi_read_list;
 	__u32			cl_r_in_flight;
 	__u32			cl_w_in_flight;
+	/* write RPC completion latency in usec/MB, average and baseline, used
+	 * to detect a congested OST, see osc_dirty_limit() */
+	__u32			cl_w_lat_avg;
+	__u32			cl_w_lat_min;
+	/* shrink the dirty cache of the OSC when its OST is congested */
+	unsigned int		cl_congest_throttle:1;
 	/* just a sum of the loi/lop pending numbers to be exported by /proc */
 	atomic_t		cl_pending_w_pages;
 	atomic_t		cl_pending_r_pages;
 	__u32			cl_max_pages_per_rpc;
 	__u32			cl_max_rpcs_in_flight;
+	/* BRW RPC size and in-flight count adapted at runtime within the two
+	 * limits above, 0 until adapted, see osc_rpc_adapt() */
+	__u32			cl_rpc_pages_cur;
+	__u32			cl_rpcs_in_flight_cur;
+	__u32			cl_brw_lat_min;	/* baseline BRW latency, usec/MB */
+	__u64			cl_adapt_bytes;	/* bytes moved this period */
+	cfs_time_t		cl_adapt_start;	/* start of period, jiffies */
+	unsigned int		cl_adaptive_rpc:1, /* adaptation enabled */
+				cl_adapt_backoff:1; /* backed off this period */
 	struct obd_histogram	cl_read_rpc_hist;
 	struct obd_histogram	cl_write_rpc_hist;
 	struct obd_histogram	cl_read_page_hist;
@@ -288,8 +310,7 @@ struct client_obd {
 	atomic_long_t		 cl_lru_busy;
 	atomic_long_t		 cl_lru_in_list;
 	atomic_long_t		 cl_unstable_count;
-	struct list_head	 cl_lru_list; /* lru page list */
-	spinlock_t		 cl_lru_list_lock; /* page list protector */
+	struct cl_lru_part	**cl_lru_parts; /* per-CPT lru page lists */
 	atomic_t		 cl_lru_shrinkers;
 
 	/* number of in flight destroy rpcs is limited to max_rpcs_in_flight */
@@ -682,57 +682,60 @@ enum interval_iter interval_search(struct interval_node *node,
 }
 EXPORT_SYMBOL(interval_search);
 
-static enum interval_iter interval_overlap_cb(struct interval_node *n,
-                                              void *args)
-{
-        *(int *)args = 1;
-        return INTERVAL_ITER_STOP;
-}
-
+/*
+ * Unlike interval_search(), only one path from the root is walked: if the
+ * left subtree has an interval ending at or after ext->start and none of
+ * its intervals overlaps @ext, then @ext ends before that interval starts,
+ * and so before all the intervals of the right subtree.
+ */
 int interval_is_overlapped(struct interval_node *root,
                            struct interval_node_extent *ext)
 {
-        int has = 0;
-        (void)interval_search(root, ext, interval_overlap_cb, &has);
-        return has;
+	struct interval_node *node = root;
+
+	while (node != NULL) {
+		if (extent_overlapped(ext, &node->in_extent))
+			return 1;
+
+		if (node->in_left != NULL &&
+		    node->in_left->in_max_high >= ext->start)
+			node = node->in_left;
+		else if (ext->end >= interval_low(node))
+			node = node->in_right;
+		else
+			break;
+	}
+
+	return 0;
 }
 EXPORT_SYMBOL(interval_is_overlapped);
 
-/* Don't expand to low. Expanding downwards is expensive, and meaningless to
- * some extents, because programs seldom do IO backward.
- *
- * The recursive algorithm of expanding low:
- * expand_low {
- *        struct interval_node *tmp;
- *        static __u64 res = 0;
- *
- *        if (root == NULL)
- *                return res;
- *        if (root->in_max_high < low) {
- *                res = max_u64(root->in_max_high + 1, res);
- *                return res;
- *        } else if (low < interval_low(root)) {
- *                interval_expand_low(root->in_left, low);
- *                return res;
- *        }
- *
- *        if (interval_high(root) < low)
- *                res = max_u64(interval_high(root) + 1, res);
- *        interval_expand_low(root->in_left, low);
- *        interval_expand_low(root->in_right, low);
- *
- *        return res;
- * }
+/*
+ * Return the lowest start the extent beginning at @low can be expanded to.
  *
- * It's much easy to eliminate the recursion, see interval_search for 
- * an example. -jay
+ * None of the intervals in the tree overlaps the extent being expanded (see
+ * interval_expand()), so those starting below @low also end below it. The
+ * highest of their ends is found along a single path using in_max_high: a
+ * node starting below @low has its whole left subtree starting below @low
+ * too.
  */
-static inline __u64 interval_expand_low(struct interval_node *root, __u64 low)
+static inline __u64 interval_expand_low(struct interval_node *node, __u64 low)
 {
-        /* we only concern the empty tree right now. */
-        if (root == NULL)
-                return 0;
-        return low;
+	__u64 result = 0;
+
+	while (node != NULL) {
+		if (interval_low(node) >= low) {
+			node = node->in_left;
+			continue;
+		}
+
+		result = max_u64(result, interval_high(node) + 1);
+		if (node->in_left != NULL)
+			result = max_u64(result, node->in_left->in_max_high + 1);
+		node = node->in_right;
+	}
+
+	return result;
 }
 
 static inline __u64 interval_expand_high(struct interval_node *node, __u64 high)
@@ -759,8 +762,7 @@ void interval_expand(struct interval_node *root,
                      struct interval_node_extent *ext,
                      struct interval_node_extent *limiter)
 {
-        /* The assertion of interval_is_overlapped is expensive because we may
-         * travel many nodes to find the overlapped node. */
+        /* interval_is_overlapped() walks only one path of the tree */
         LASSERT(interval_is_overlapped(root, ext) == 0);
         if (!limiter || limiter->start < ext->start)
                 ext->start = interval_expand_low(root, ext->start);
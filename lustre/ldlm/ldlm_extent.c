@@ -153,11 +153,6 @@ static void ldlm_extent_internal_policy_granted(struct ldlm_lock *req,
                 if (conflicting > 4)
                         limiter.start = req_start;
 
-                if (interval_is_overlapped(tree->lit_root, &ext))
-                        CDEBUG(D_INFO, 
-                               "req_mode = %d, tree->lit_mode = %d, "
-                               "tree->lit_size = %d\n",
-                               req_mode, tree->lit_mode, tree->lit_size);
                 interval_expand(tree->lit_root, &ext, &limiter);
                 limiter.start = max(limiter.start, ext.start);
                 limiter.end = min(limiter.end, ext.end);
@@ -284,6 +279,12 @@ static void ldlm_extent_policy(struct ldlm_resource *res,
                 /* fast-path whole file locks */
                 return;
 
+	/* Lock ahead requests want exactly the extent asked for, so that
+	 * locks requested by different clients on neighbouring extents of
+	 * a shared file do not conflict with each other. */
+	if (ldlm_is_no_expansion(lock))
+		return;
+
         ldlm_extent_internal_policy_granted(lock, &new_ex);
         ldlm_extent_internal_policy_waiting(lock, &new_ex);
 
@@ -921,6 +922,10 @@ void ldlm_extent_add_lock(struct ldlm_resource *res,
                 LASSERT(tmp != NULL);
                 ldlm_interval_free(tmp);
                 ldlm_interval_attach(to_ldlm_interval(found), lock);
+	} else if (ns_is_server(ldlm_res_to_ns(res))) {
+		/* a new interval node, shared by the locks joining it later */
+		atomic_long_add(sizeof(*node),
+				&ldlm_res_to_ns(res)->ns_pool.pl_granted_bytes);
         }
         res->lr_itree[idx].lit_size++;
 
@@ -951,6 +956,9 @@ void ldlm_extent_unlink_lock(struct ldlm_lock *lock)
         if (node) {
                 interval_erase(&node->li_node, &tree->lit_root);
                 ldlm_interval_free(node);
+		if (ns_is_server(ldlm_res_to_ns(res)))
+			atomic_long_sub(sizeof(*node),
+				&ldlm_res_to_ns(res)->ns_pool.pl_granted_bytes);
         }
 }
 
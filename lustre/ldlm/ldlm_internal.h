@@ -106,6 +106,11 @@ enum {
                                       * sending nor waiting for any rpcs) */
 };
 
+/* A lock taken back from the LRU within this many seconds of its enqueue
+ * is still used by the operation which enqueued it, e.g. lookup then stat,
+ * and does not count as a reuse. */
+#define LDLM_LRU_REUSE_MIN_AGE	1
+
 int ldlm_cancel_lru(struct ldlm_namespace *ns, int nr,
 		    ldlm_cancel_flags_t sync, int flags);
 int ldlm_cancel_lru_local(struct ldlm_namespace *ns,
@@ -133,6 +138,12 @@ struct ldlm_cb_set_arg {
 	union ldlm_gl_desc		*gl_desc; /* glimpse AST descriptor */
 };
 
+/* max number of locks in one batched blocking AST, bounded by the size of
+ * the reply which lists the handles unknown to the client */
+#define LDLM_BL_BATCH_MAX	32
+/* max number of ast_work entries scanned for locks to batch with */
+#define LDLM_BL_BATCH_SCAN	256
+
 typedef enum {
 	LDLM_WORK_BL_AST,
 	LDLM_WORK_CP_AST,
@@ -182,6 +193,11 @@ int ldlm_bl_to_thread_list(struct ldlm_namespace *ns,
 
 void ldlm_handle_bl_callback(struct ldlm_namespace *ns,
                              struct ldlm_lock_desc *ld, struct ldlm_lock *lock);
+#ifdef HAVE_SERVER_SUPPORT
+int ldlm_server_blocking_ast_batch(struct ldlm_lock **locks, int count,
+				   struct ldlm_lock_desc *desc,
+				   struct ldlm_cb_set_arg *arg);
+#endif
 
 #ifdef HAVE_SERVER_SUPPORT
 /* ldlm_plain.c */
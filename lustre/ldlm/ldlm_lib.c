@@ -371,8 +371,6 @@ int client_obd_setup(struct obd_device *obddev, struct lustre_cfg *lcfg)
 	atomic_set(&cli->cl_lru_shrinkers, 0);
 	atomic_long_set(&cli->cl_lru_busy, 0);
 	atomic_long_set(&cli->cl_lru_in_list, 0);
-	INIT_LIST_HEAD(&cli->cl_lru_list);
-	spin_lock_init(&cli->cl_lru_list_lock);
 	atomic_long_set(&cli->cl_unstable_count, 0);
 
 	init_waitqueue_head(&cli->cl_destroy_waitq);
@@ -400,6 +398,9 @@ int client_obd_setup(struct obd_device *obddev, struct lustre_cfg *lcfg)
 	 * it will be updated at OSC connection time. */
 	cli->cl_chunkbits = PAGE_CACHE_SHIFT;
 
+	/* BRW RPC size and count adaptation is enabled with adaptive_rpc */
+	cli->cl_adaptive_rpc = 0;
+
 	if (!strcmp(name, LUSTRE_MDC_NAME)) {
 		cli->cl_max_rpcs_in_flight = OBD_MAX_RIF_DEFAULT;
 	} else if (totalram_pages >> (20 - PAGE_CACHE_SHIFT) <= 128 /* MB */) {
@@ -660,7 +661,7 @@ int server_disconnect_export(struct obd_export *exp)
 
 		spin_lock(&svcpt->scp_rep_lock);
 
-		list_del_init(&rs->rs_exp_list);
+		ptlrpc_rs_exp_del(rs);
 		spin_lock(&rs->rs_lock);
 		ptlrpc_schedule_difficult_reply(rs);
 		spin_unlock(&rs->rs_lock);
@@ -2432,6 +2433,7 @@ void target_send_reply(struct ptlrpc_request *req, int rc, int fail_id)
 	LASSERT(rs->rs_export == NULL);
 	LASSERT(list_empty(&rs->rs_obd_list));
 	LASSERT(list_empty(&rs->rs_exp_list));
+	LASSERT(hlist_unhashed(&rs->rs_xid_hash));
 
 	exp = class_export_get(req->rq_export);
 
@@ -2454,7 +2456,7 @@ void target_send_reply(struct ptlrpc_request *req, int rc, int fail_id)
 	spin_unlock(&exp->exp_uncommitted_replies_lock);
 
 	spin_lock(&exp->exp_lock);
-	list_add_tail(&rs->rs_exp_list, &exp->exp_outstanding_replies);
+	ptlrpc_rs_exp_add(exp, rs);
 	spin_unlock(&exp->exp_lock);
 
 	netrc = target_send_reply_msg(req, rc, fail_id);
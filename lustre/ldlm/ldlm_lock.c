@@ -307,6 +307,29 @@ void ldlm_lock_add_to_lru(struct ldlm_lock *lock)
 	EXIT;
 }
 
+/**
+ * Removes LDLM lock \a lock from LRU as it is going to be used again, and
+ * counts the reuse for the LRU cancel policy, at most once per stay in the
+ * LRU. Obtains the LRU lock first.
+ */
+static void ldlm_lock_reuse_from_lru(struct ldlm_lock *lock)
+{
+	struct ldlm_namespace *ns = ldlm_lock_to_ns(lock);
+
+	if (ldlm_is_ns_srv(lock)) {
+		LASSERT(list_empty(&lock->l_lru));
+		return;
+	}
+
+	spin_lock(&ns->ns_lock);
+	if (ldlm_lock_remove_from_lru_nolock(lock) &&
+	    lock->l_lru_reuse < ns->ns_lru_reuse_max &&
+	    cfs_time_current_sec() - lock->l_last_activity >
+	    LDLM_LRU_REUSE_MIN_AGE)
+		lock->l_lru_reuse++;
+	spin_unlock(&ns->ns_lock);
+}
+
 /**
  * Moves LDLM lock \a lock that is already in namespace LRU to the tail of
  * the LRU. Performs necessary LRU locking
@@ -737,7 +760,7 @@ EXPORT_SYMBOL(ldlm_lock_addref);
  */
 void ldlm_lock_addref_internal_nolock(struct ldlm_lock *lock, __u32 mode)
 {
-        ldlm_lock_remove_from_lru(lock);
+	ldlm_lock_reuse_from_lru(lock);
         if (mode & (LCK_NL | LCK_CR | LCK_PR)) {
                 lock->l_readers++;
                 lu_ref_add_atomic(&lock->l_reference, "reader", lock);
@@ -1792,8 +1815,71 @@ int ldlm_reprocess_queue(struct ldlm_resource *res, struct list_head *queue,
 }
 #endif
 
+#ifdef HAVE_SERVER_SUPPORT
+/**
+ * Pull from \a arg->list the locks which can share one blocking AST RPC with
+ * \a lock: granted to the same client and blocked by the same lock with the
+ * same AST hints. \a lock is put into \a locks first.
+ *
+ * Only LDLM_BL_BATCH_SCAN entries of the list are looked at, so that a long
+ * list of ASTs to many clients is not scanned over and over again.
+ *
+ * \retval number of locks in \a locks
+ */
+static int ldlm_bl_batch_collect(struct ldlm_cb_set_arg *arg,
+				 struct ldlm_lock *lock,
+				 struct ldlm_lock **locks)
+{
+	struct ldlm_lock *tmp;
+	struct ldlm_lock *next;
+	int		  scanned = 0;
+	int		  count = 1;
+
+	locks[0] = lock;
+	list_for_each_entry_safe(tmp, next, arg->list, l_bl_ast) {
+		if (count == LDLM_BL_BATCH_MAX ||
+		    ++scanned > LDLM_BL_BATCH_SCAN)
+			break;
+
+		if (tmp->l_export != lock->l_export ||
+		    tmp->l_blocking_lock != lock->l_blocking_lock ||
+		    tmp->l_blocking_ast != lock->l_blocking_ast)
+			continue;
+
+		lock_res_and_lock(tmp);
+		if (ldlm_is_cancel_on_block(tmp) ||
+		    (tmp->l_flags & LDLM_FL_AST_MASK) !=
+		    (lock->l_flags & LDLM_FL_AST_MASK)) {
+			unlock_res_and_lock(tmp);
+			continue;
+		}
+		list_del_init(&tmp->l_bl_ast);
+
+		LASSERT(ldlm_is_ast_sent(tmp));
+		LASSERT(tmp->l_bl_ast_run == 0);
+		LASSERT(tmp->l_blocking_lock);
+		tmp->l_bl_ast_run++;
+		unlock_res_and_lock(tmp);
+
+		locks[count++] = tmp;
+	}
+
+	return count;
+}
+
+static inline int ldlm_bl_batch_allowed(struct ldlm_lock *lock)
+{
+	return lock->l_blocking_ast == ldlm_server_blocking_ast &&
+	       lock->l_export != NULL && exp_connect_bl_batch(lock->l_export) &&
+	       !ldlm_is_cancel_on_block(lock);
+}
+#endif /* HAVE_SERVER_SUPPORT */
+
 /**
  * Process a call to blocking AST callback for a lock in ast_work list
+ *
+ * If the client supports it, the other locks of the same client blocked by
+ * the same lock are taken from the list too and notified in the same RPC.
  */
 static int
 ldlm_work_bl_ast_lock(struct ptlrpc_request_set *rqset, void *opaq)
@@ -1802,6 +1888,10 @@ ldlm_work_bl_ast_lock(struct ptlrpc_request_set *rqset, void *opaq)
 	struct ldlm_lock_desc   d;
 	int                     rc;
 	struct ldlm_lock       *lock;
+#ifdef HAVE_SERVER_SUPPORT
+	struct ldlm_lock      **locks = NULL;
+	int                     count = 1;
+#endif
 	ENTRY;
 
 	if (list_empty(arg->list))
@@ -1821,7 +1911,28 @@ ldlm_work_bl_ast_lock(struct ptlrpc_request_set *rqset, void *opaq)
 
 	ldlm_lock2desc(lock->l_blocking_lock, &d);
 
-	rc = lock->l_blocking_ast(lock, &d, (void *)arg, LDLM_CB_BLOCKING);
+#ifdef HAVE_SERVER_SUPPORT
+	if (ldlm_bl_batch_allowed(lock)) {
+		OBD_ALLOC(locks, LDLM_BL_BATCH_MAX * sizeof(*locks));
+		if (locks != NULL)
+			count = ldlm_bl_batch_collect(arg, lock, locks);
+	}
+
+	if (count > 1) {
+		rc = ldlm_server_blocking_ast_batch(locks, count, &d, arg);
+		while (--count > 0) {
+			LDLM_LOCK_RELEASE(locks[count]->l_blocking_lock);
+			locks[count]->l_blocking_lock = NULL;
+			LDLM_LOCK_RELEASE(locks[count]);
+		}
+	} else
+#endif
+		rc = lock->l_blocking_ast(lock, &d, (void *)arg,
+					  LDLM_CB_BLOCKING);
+#ifdef HAVE_SERVER_SUPPORT
+	if (locks != NULL)
+		OBD_FREE(locks, LDLM_BL_BATCH_MAX * sizeof(*locks));
+#endif
 	LDLM_LOCK_RELEASE(lock->l_blocking_lock);
 	lock->l_blocking_lock = NULL;
 	LDLM_LOCK_RELEASE(lock);
@@ -61,6 +61,9 @@ static int ldlm_refcount;
 struct ldlm_cb_async_args {
         struct ldlm_cb_set_arg *ca_set_arg;
         struct ldlm_lock       *ca_lock;
+	/* all locks of a batched blocking AST, ca_lock is the first one */
+	struct ldlm_lock      **ca_locks;
+	int			ca_count;
 };
 
 /* LDLM state */
@@ -680,6 +683,55 @@ static int ldlm_handle_ast_error(struct ldlm_lock *lock,
 	return rc;
 }
 
+/**
+ * Handle the reply to a batched blocking AST. The client lists the handles
+ * of the locks it does not know about (anymore) in the reply, those are
+ * treated as if a separate blocking AST for them returned -EINVAL.
+ */
+static int ldlm_bl_batch_interpret(struct ptlrpc_request *req,
+				   struct ldlm_cb_async_args *ca, int rc)
+{
+	struct ldlm_request	*stale = NULL;
+	int			 result = 0;
+	int			 i;
+	int			 j;
+
+	if (rc == 0 && ca->ca_count > 1) {
+		stale = req_capsule_server_get(&req->rq_pill, &RMF_DLM_REQ);
+		if (stale == NULL || stale->lock_count > ca->ca_count ||
+		    req_capsule_get_size(&req->rq_pill, &RMF_DLM_REQ,
+					 RCL_SERVER) <
+		    ldlm_request_bufsize(stale->lock_count, LDLM_BL_CALLBACK)) {
+			DEBUG_REQ(D_ERROR, req, "bad batched blocking AST reply");
+			rc = -EPROTO;
+		}
+	}
+
+	for (i = 0; i < ca->ca_count; i++) {
+		struct ldlm_lock *lock = ca->ca_locks[i];
+		int		  lrc = rc;
+
+		for (j = 0; lrc == 0 && stale != NULL &&
+			    j < stale->lock_count; j++) {
+			if (stale->lock_handle[j].cookie ==
+			    lock->l_remote_handle.cookie)
+				lrc = -EINVAL;
+		}
+
+		if (lrc != 0 &&
+		    ldlm_handle_ast_error(lock, req, lrc,
+					  "blocking") == -ERESTART)
+			result = -ERESTART;
+
+		/* release extra reference taken in
+		 * ldlm_server_blocking_ast_batch() */
+		LDLM_LOCK_RELEASE(lock);
+	}
+	OBD_FREE(ca->ca_locks, LDLM_BL_BATCH_MAX * sizeof(*ca->ca_locks));
+
+	return result;
+}
+
 static int ldlm_cb_interpret(const struct lu_env *env,
                              struct ptlrpc_request *req, void *data, int rc)
 {
@@ -690,6 +742,12 @@ static int ldlm_cb_interpret(const struct lu_env *env,
 
         LASSERT(lock != NULL);
 
+	if (ca->ca_locks != NULL) {
+		if (ldlm_bl_batch_interpret(req, ca, rc) == -ERESTART)
+			atomic_inc(&arg->restart);
+		RETURN(0);
+	}
+
 	switch (arg->type) {
 	case LDLM_GL_CALLBACK:
 		/* Update the LVB from disk if the AST failed
@@ -737,8 +795,17 @@ static void ldlm_update_resend(struct ptlrpc_request *req, void *data)
 {
 	struct ldlm_cb_async_args *ca   = data;
 	struct ldlm_lock          *lock = ca->ca_lock;
+	int			   i;
+
+	if (ca->ca_locks == NULL) {
+		ldlm_refresh_waiting_lock(lock, ldlm_bl_timeout(lock));
+		return;
+	}
 
-	ldlm_refresh_waiting_lock(lock, ldlm_bl_timeout(lock));
+	for (i = 0; i < ca->ca_count; i++) {
+		lock = ca->ca_locks[i];
+		ldlm_refresh_waiting_lock(lock, ldlm_bl_timeout(lock));
+	}
 }
 
 static inline int ldlm_ast_fini(struct ptlrpc_request *req,
@@ -899,6 +966,118 @@ int ldlm_server_blocking_ast(struct ldlm_lock *lock,
 }
 EXPORT_SYMBOL(ldlm_server_blocking_ast);
 
+/**
+ * Send a single blocking AST for \a count granted locks of one client that
+ * all conflict with the lock described by \a desc, see
+ * ldlm_work_bl_ast_lock(). \a locks has LDLM_BL_BATCH_MAX slots.
+ *
+ * Only the locks still granted are put into the RPC, each of them is added
+ * to the waiting list as for a regular blocking AST. The client cancels the
+ * unused ones in as few LDLM_CANCEL RPCs as possible.
+ */
+int ldlm_server_blocking_ast_batch(struct ldlm_lock **locks, int count,
+				   struct ldlm_lock_desc *desc,
+				   struct ldlm_cb_set_arg *arg)
+{
+	struct obd_export	  *exp = locks[0]->l_export;
+	struct ldlm_cb_async_args *ca;
+	struct ldlm_request	  *body;
+	struct ptlrpc_request	  *req;
+	struct ldlm_lock	 **sent;
+	int			   i;
+	int			   n = 0;
+	int			   rc;
+	ENTRY;
+
+	LASSERT(count > 1 && count <= LDLM_BL_BATCH_MAX);
+	if (exp->exp_obd->obd_recovering != 0)
+		LDLM_ERROR(locks[0], "BUG 6063: lock collide during recovery");
+
+	OBD_ALLOC(sent, LDLM_BL_BATCH_MAX * sizeof(*sent));
+	if (sent == NULL)
+		RETURN(-ENOMEM);
+
+	req = ptlrpc_request_alloc(exp->exp_imp_reverse,
+				  &RQF_LDLM_BL_CALLBACK_BATCH);
+	if (req == NULL)
+		GOTO(out, rc = -ENOMEM);
+
+	req_capsule_set_size(&req->rq_pill, &RMF_DLM_REQ, RCL_CLIENT,
+			     ldlm_request_bufsize(count, LDLM_BL_CALLBACK));
+	rc = ptlrpc_request_pack(req, LUSTRE_DLM_VERSION, LDLM_BL_CALLBACK);
+	if (rc != 0) {
+		ptlrpc_request_free(req);
+		GOTO(out, rc);
+	}
+
+	body = req_capsule_client_get(&req->rq_pill, &RMF_DLM_REQ);
+	body->lock_desc = *desc;
+	body->lock_flags |= ldlm_flags_to_wire(locks[0]->l_flags &
+					       LDLM_FL_AST_MASK);
+
+	for (i = 0; i < count; i++) {
+		struct ldlm_lock *lock = locks[i];
+
+		ldlm_lock_reorder_req(lock);
+
+		lock_res_and_lock(lock);
+		if (lock->l_granted_mode != lock->l_req_mode ||
+		    ldlm_is_destroyed(lock)) {
+			unlock_res_and_lock(lock);
+			LDLM_DEBUG(lock, "lock not granted or destroyed, "
+				   "not sending blocking AST");
+			continue;
+		}
+		LASSERT(!ldlm_is_cancel_on_block(lock));
+		body->lock_handle[n] = lock->l_remote_handle;
+		ldlm_add_waiting_lock(lock);
+		unlock_res_and_lock(lock);
+
+		LDLM_DEBUG(lock, "server preparing batched blocking AST");
+		lock->l_last_activity = cfs_time_current_sec();
+		sent[n++] = LDLM_LOCK_GET(lock);
+	}
+
+	if (n == 0) {
+		ptlrpc_req_finished(req);
+		GOTO(out, rc = 0);
+	}
+
+	body->lock_count = n;
+	req_capsule_shrink(&req->rq_pill, &RMF_DLM_REQ,
+			   ldlm_request_bufsize(n, LDLM_BL_CALLBACK), RCL_CLIENT);
+	/* room for all the handles in case the client has none of them */
+	req_capsule_set_size(&req->rq_pill, &RMF_DLM_REQ, RCL_SERVER,
+			     ldlm_request_bufsize(n, LDLM_BL_CALLBACK));
+	ptlrpc_request_set_replen(req);
+
+	CLASSERT(sizeof(*ca) <= sizeof(req->rq_async_args));
+	ca = ptlrpc_req_async_args(req);
+	ca->ca_set_arg = arg;
+	ca->ca_lock = sent[0];
+	ca->ca_locks = sent;
+	ca->ca_count = n;
+
+	req->rq_interpret_reply = ldlm_cb_interpret;
+	/* Do not resend after lock callback timeout */
+	req->rq_delay_limit = ldlm_bl_timeout(sent[0]);
+	req->rq_resend_cb = ldlm_update_resend;
+	req->rq_send_state = LUSTRE_IMP_FULL;
+	/* ptlrpc_request_pack already set timeout */
+	if (AT_OFF)
+		req->rq_timeout = ldlm_get_rq_timeout();
+
+	if (exp->exp_nid_stats && exp->exp_nid_stats->nid_ldlm_stats)
+		lprocfs_counter_incr(exp->exp_nid_stats->nid_ldlm_stats,
+				     LDLM_BL_CALLBACK - LDLM_FIRST_OPC);
+
+	ptlrpc_set_add_req(arg->set, req);
+	RETURN(0);
+out:
+	OBD_FREE(sent, LDLM_BL_BATCH_MAX * sizeof(*sent));
+	RETURN(rc);
+}
+
 /**
  * ->l_completion_ast callback for a remote lock in server namespace.
  *
@@ -2131,6 +2310,125 @@ static int ldlm_handle_qc_callback(struct ptlrpc_request *req)
 	return 0;
 }
 
+/**
+ * Callback handler for a blocking AST carrying several locks, which servers
+ * send to clients connected with OBD_CONNECT_BL_BATCH.
+ *
+ * The unused locks are cancelled right away as a list, the same way as aged
+ * locks from the LRU are, so that their cancels reach the server in as few
+ * LDLM_CANCEL RPCs as possible. The locks in use get the usual per-lock
+ * blocking callback. The handles of the locks which are gone are returned
+ * to the server in the reply, as -EINVAL would be for a single lock.
+ */
+static void ldlm_handle_bl_batch(struct ptlrpc_request *req,
+				 struct ldlm_namespace *ns,
+				 struct ldlm_request *dlm_req)
+{
+	struct req_capsule	*pill = &req->rq_pill;
+	struct list_head	 cancels = LIST_HEAD_INIT(cancels);
+	struct ldlm_request	*stale;
+	struct ldlm_lock	*lock;
+	int			 count = dlm_req->lock_count;
+	int			 ncancel = 0;
+	int			 i;
+	int			 rc;
+	ENTRY;
+
+	if (req_capsule_get_size(pill, &RMF_DLM_REQ, RCL_CLIENT) <
+	    ldlm_request_bufsize(count, LDLM_BL_CALLBACK)) {
+		rc = ldlm_callback_reply(req, -EPROTO);
+		ldlm_callback_errmsg(req, "Operate with short lock list", rc,
+				     NULL);
+		RETURN_EXIT;
+	}
+
+	req_capsule_extend(pill, &RQF_LDLM_BL_CALLBACK_BATCH);
+	req_capsule_set_size(pill, &RMF_DLM_REQ, RCL_SERVER,
+			     ldlm_request_bufsize(count, LDLM_BL_CALLBACK));
+	rc = req_capsule_server_pack(pill);
+	if (rc != 0) {
+		rc = ldlm_callback_reply(req, rc);
+		ldlm_callback_errmsg(req, "Pack batch reply", rc, NULL);
+		RETURN_EXIT;
+	}
+	stale = req_capsule_server_get(pill, &RMF_DLM_REQ);
+	stale->lock_count = 0;
+
+	for (i = 0; i < count; i++) {
+		struct lustre_handle *lockh = &dlm_req->lock_handle[i];
+
+		lock = ldlm_handle2lock_long(lockh, 0);
+		if (lock == NULL) {
+			CDEBUG(D_DLMTRACE, "callback on lock "LPX64" - lock "
+			       "disappeared\n", lockh->cookie);
+			stale->lock_handle[stale->lock_count++] = *lockh;
+			lockh->cookie = 0ULL;
+			continue;
+		}
+
+		lock_res_and_lock(lock);
+		lock->l_flags |= ldlm_flags_from_wire(dlm_req->lock_flags &
+						      LDLM_FL_AST_MASK);
+		if ((ldlm_is_canceling(lock) && ldlm_is_bl_done(lock)) ||
+		    ldlm_is_failed(lock)) {
+			unlock_res_and_lock(lock);
+			LDLM_DEBUG(lock, "callback on lock "LPX64" - lock "
+				   "disappeared", lockh->cookie);
+			LDLM_LOCK_RELEASE(lock);
+			stale->lock_handle[stale->lock_count++] = *lockh;
+			lockh->cookie = 0ULL;
+			continue;
+		}
+
+		ldlm_set_bl_ast(lock);
+		/* A lock in LRU has no readers and writers, cancel it now.
+		 * CBPENDING makes sure it cannot gain any from now on. */
+		if (ldlm_lock_remove_from_lru(lock) != 0 &&
+		    !ldlm_is_canceling(lock) && !ldlm_is_cancel_on_block(lock)) {
+			LASSERT(!lock->l_readers && !lock->l_writers);
+			lock->l_flags |= LDLM_FL_CBPENDING | LDLM_FL_CANCELING;
+			LASSERT(list_empty(&lock->l_bl_ast));
+			list_add(&lock->l_bl_ast, &cancels);
+			unlock_res_and_lock(lock);
+			lockh->cookie = 0ULL;
+			ncancel++;
+			continue;
+		}
+		unlock_res_and_lock(lock);
+		LDLM_LOCK_RELEASE(lock);
+	}
+
+	req_capsule_shrink(pill, &RMF_DLM_REQ,
+			   ldlm_request_bufsize(stale->lock_count,
+						LDLM_BL_CALLBACK),
+			   RCL_SERVER);
+	rc = ldlm_callback_reply(req, 0);
+	if (req->rq_no_reply || rc)
+		ldlm_callback_errmsg(req, "Batch process", rc, NULL);
+
+	/* the locks still in use, as for a single blocking AST */
+	for (i = 0; i < count; i++) {
+		if (!lustre_handle_is_used(&dlm_req->lock_handle[i]))
+			continue;
+
+		lock = ldlm_handle2lock_long(&dlm_req->lock_handle[i], 0);
+		if (lock == NULL)
+			continue;
+
+		if (ldlm_bl_to_thread_lock(ns, &dlm_req->lock_desc, lock))
+			ldlm_handle_bl_callback(ns, &dlm_req->lock_desc, lock);
+	}
+
+	if (ncancel > 0 &&
+	    ldlm_bl_to_thread_list(ns, NULL, &cancels, ncancel, LCF_ASYNC)) {
+		ncancel = ldlm_cli_cancel_list_local(&cancels, ncancel,
+						     LCF_BL_AST);
+		ldlm_cli_cancel_list(&cancels, ncancel, NULL, 0);
+	}
+
+	EXIT;
+}
+
 /* TODO: handle requests in a similar way as MDT: see mdt_handle_common() */
 static int ldlm_callback_handler(struct ptlrpc_request *req)
 {
@@ -2246,6 +2544,14 @@ static int ldlm_callback_handler(struct ptlrpc_request *req)
                         CERROR("ldlm_cli_cancel: %d\n", rc);
         }
 
+	if (lustre_msg_get_opc(req->rq_reqmsg) == LDLM_BL_CALLBACK &&
+	    dlm_req->lock_count > 1) {
+		CDEBUG(D_INODE, "blocking ast for %u locks\n",
+		       dlm_req->lock_count);
+		ldlm_handle_bl_batch(req, ns, dlm_req);
+		RETURN(0);
+	}
+
         lock = ldlm_handle2lock_long(&dlm_req->lock_handle[0], 0);
         if (!lock) {
                 CDEBUG(D_DLMTRACE, "callback on lock "LPX64" - lock "
@@ -3092,11 +3398,11 @@ void ldlm_exit(void)
 {
 	if (ldlm_refcount)
 		CERROR("ldlm_refcount is %d in ldlm_exit!\n", ldlm_refcount);
+	/* ldlm_lock_put() and ldlm_resource_putref() use RCU to free locks
+	 * and resources, so need call rcu_barrier() to wait for the pending
+	 * callbacks before the slabs are destroyed. */
+	rcu_barrier();
 	kmem_cache_destroy(ldlm_resource_slab);
-	/* ldlm_lock_put() use RCU to call ldlm_lock_free, so need call
-	 * synchronize_rcu() to wait a grace period elapsed, so that
-	 * ldlm_lock_free() get a chance to be called. */
-	synchronize_rcu();
 	kmem_cache_destroy(ldlm_lock_slab);
 	kmem_cache_destroy(ldlm_interval_slab);
 }
@@ -82,6 +82,9 @@
  * side (tunable);
  *
  * pl_granted - Number of granted locks (calculated);
+ * pl_granted_bytes - Memory pinned by granted locks on server (calculated);
+ * pl_mem_aware - Recalculate SLV against memory used by granted locks and
+ * free server memory rather than lock count (tunable);
  * pl_grant_rate - Number of granted locks for last T (calculated);
  * pl_cancel_rate - Number of canceled locks for last T (calculated);
  * pl_grant_speed - Grant speed (GR - CR) for last T (calculated);
@@ -97,6 +100,8 @@
 
 #define DEBUG_SUBSYSTEM S_LDLM
 
+#include <linux/swap.h> /* nr_free_pages() */
+#include <linux/vmstat.h> /* global_page_state() */
 #include <lustre_dlm.h>
 #include <cl_object.h>
 #include <obd_class.h>
@@ -141,6 +146,12 @@
  */
 #define LDLM_POOL_SLV_SHIFT (10)
 
+/*
+ * Memory-aware pools consider the server short of memory when less than
+ * 1/16 of RAM is free or holds reclaimable page cache.
+ */
+#define LDLM_POOL_MEM_LOW_SHIFT (4)
+
 extern struct proc_dir_entry *ldlm_ns_proc_dir;
 
 static inline __u64 dru(__u64 val, __u32 shift, int round_up)
@@ -220,6 +231,73 @@ static inline int ldlm_pool_granted(struct ldlm_pool *pl)
 	return atomic_read(&pl->pl_granted);
 }
 
+/**
+ * Returns the memory pinned on the server by resource \a res while it has
+ * granted locks: the resource itself and its LVB, which the locks share.
+ * Interval nodes, also shared by the extent locks of the same mode and
+ * extent, are accounted by ldlm_extent_add_lock() and
+ * ldlm_extent_unlink_lock().
+ *
+ * The LVB is set up lazily and lr_lvb_len holds an error if that failed,
+ * so the amount charged is kept in ldlm_resource::lr_pool_mem and exactly
+ * that is released again.
+ */
+static inline long ldlm_pool_res_mem(struct ldlm_resource *res)
+{
+	return sizeof(*res) + max(res->lr_lvb_len, 0);
+}
+
+/**
+ * Returns the number of pages the server can still allocate from without
+ * going into direct reclaim: free pages and the page cache, which the VM
+ * drops long before the locks, which are only freed on cancel.
+ */
+static unsigned long ldlm_pool_mem_avail(void)
+{
+	return nr_free_pages() + global_page_state(NR_ACTIVE_FILE) +
+	       global_page_state(NR_INACTIVE_FILE);
+}
+
+/**
+ * Returns the limit SLV and grant plan of \a pl are recalculated against.
+ *
+ * The pool limit is a number of bare locks. In memory-aware mode it is
+ * scaled down by the average memory actually pinned per granted lock, and
+ * further by the shortage of available memory on the server, so that SLV drops
+ * and clients shrink their LRUs before the server runs out of memory.
+ *
+ * \pre ->pl_lock is locked.
+ */
+static __u32 ldlm_pool_recalc_limit(struct ldlm_pool *pl)
+{
+	__u64 limit = ldlm_pool_get_limit(pl);
+	unsigned long low, avail;
+	long bytes, avg;
+	int granted;
+
+	if (atomic_read(&pl->pl_mem_aware) == 0)
+		return limit;
+
+	granted = ldlm_pool_granted(pl);
+	bytes = atomic_long_read(&pl->pl_granted_bytes);
+	if (granted > 0 && bytes > 0) {
+		avg = bytes / granted;
+		if (avg > (long)sizeof(struct ldlm_lock)) {
+			limit *= sizeof(struct ldlm_lock);
+			do_div(limit, (__u32)avg);
+		}
+	}
+
+	low = NUM_CACHEPAGES >> LDLM_POOL_MEM_LOW_SHIFT;
+	avail = ldlm_pool_mem_avail();
+	if (avail < low) {
+		limit *= avail;
+		do_div(limit, (__u32)low);
+	}
+
+	return max_t(__u32, limit, 1);
+}
+
 /**
  * Recalculates next grant limit on passed \a pl.
  *
@@ -229,7 +307,7 @@ static void ldlm_pool_recalc_grant_plan(struct ldlm_pool *pl)
 {
 	int granted, grant_step, limit;
 
-	limit = ldlm_pool_get_limit(pl);
+	limit = ldlm_pool_recalc_limit(pl);
 	granted = ldlm_pool_granted(pl);
 
 	grant_step = ldlm_pool_t2gsp(pl->pl_recalc_period);
@@ -257,7 +335,7 @@ static void ldlm_pool_recalc_slv(struct ldlm_pool *pl)
 
 	slv = pl->pl_server_lock_volume;
 	grant_plan = pl->pl_grant_plan;
-	limit = ldlm_pool_get_limit(pl);
+	limit = ldlm_pool_recalc_limit(pl);
 	granted = ldlm_pool_granted(pl);
 	round_up = granted < limit;
 
@@ -667,8 +745,9 @@ EXPORT_SYMBOL(ldlm_pool_setup);
 static int lprocfs_pool_state_seq_show(struct seq_file *m, void *unused)
 {
 	int granted, grant_rate, cancel_rate, grant_step;
-	int grant_speed, grant_plan, lvf;
+	int grant_speed, grant_plan, lvf, mem_aware;
 	struct ldlm_pool *pl = m->private;
+	long granted_bytes;
 	__u64 slv, clv;
 	__u32 limit;
 
@@ -683,6 +762,8 @@ static int lprocfs_pool_state_seq_show(struct seq_file *m, void *unused)
 	grant_speed = grant_rate - cancel_rate;
 	lvf = atomic_read(&pl->pl_lock_volume_factor);
 	grant_step = ldlm_pool_t2gsp(pl->pl_recalc_period);
+	granted_bytes = atomic_long_read(&pl->pl_granted_bytes);
+	mem_aware = atomic_read(&pl->pl_mem_aware);
 	spin_unlock(&pl->pl_lock);
 
 	seq_printf(m, "LDLM pool state (%s):\n"
@@ -700,6 +781,10 @@ static int lprocfs_pool_state_seq_show(struct seq_file *m, void *unused)
 		      "  G:   %d\n" "  L:   %d\n",
 		      grant_rate, cancel_rate, grant_speed,
 		      granted, limit);
+	if (ns_is_server(ldlm_pl2ns(pl))) {
+		seq_printf(m, "  GM:  %ld\n" "  MA:  %d\n",
+			      granted_bytes, mem_aware);
+	}
 	return 0;
 }
 LPROC_SEQ_FOPS_RO(lprocfs_pool_state);
@@ -789,6 +874,9 @@ static int ldlm_pool_proc_init(struct ldlm_pool *pl)
 		     pl, &lprocfs_recalc_period_fops);
 	ldlm_add_var(&pool_vars[0], pl->pl_proc_dir, "lock_volume_factor",
 		     &pl->pl_lock_volume_factor, &ldlm_pool_rw_atomic_fops);
+	if (ns_is_server(ns))
+		ldlm_add_var(&pool_vars[0], pl->pl_proc_dir, "mem_aware",
+			     &pl->pl_mem_aware, &ldlm_pool_rw_atomic_fops);
 	ldlm_add_var(&pool_vars[0], pl->pl_proc_dir, "state", pl,
 		     &lprocfs_pool_state_fops);
 
@@ -858,6 +946,8 @@ int ldlm_pool_init(struct ldlm_pool *pl, struct ldlm_namespace *ns,
 
 	spin_lock_init(&pl->pl_lock);
 	atomic_set(&pl->pl_granted, 0);
+	atomic_long_set(&pl->pl_granted_bytes, 0);
+	atomic_set(&pl->pl_mem_aware, 0);
 	pl->pl_recalc_time = cfs_time_current_sec();
 	atomic_set(&pl->pl_lock_volume_factor, 1);
 
@@ -928,8 +1018,18 @@ void ldlm_pool_add(struct ldlm_pool *pl, struct ldlm_lock *lock)
 	 * enqueue/cancel rpc. Also we do not want to run out of stack
 	 * with too long call paths.
 	 */
-	if (ns_is_server(ldlm_pl2ns(pl)))
+	if (ns_is_server(ldlm_pl2ns(pl))) {
+		struct ldlm_resource *res = lock->l_resource;
+
+		atomic_long_add(sizeof(*lock), &pl->pl_granted_bytes);
+		/* first granted lock pins the resource */
+		if (list_is_singular(&res->lr_granted)) {
+			res->lr_pool_mem = ldlm_pool_res_mem(res);
+			atomic_long_add(res->lr_pool_mem,
+					&pl->pl_granted_bytes);
+		}
 		ldlm_pool_recalc(pl);
+	}
 }
 EXPORT_SYMBOL(ldlm_pool_add);
 
@@ -950,8 +1050,18 @@ void ldlm_pool_del(struct ldlm_pool *pl, struct ldlm_lock *lock)
 
 	lprocfs_counter_incr(pl->pl_stats, LDLM_POOL_CANCEL_STAT);
 
-	if (ns_is_server(ldlm_pl2ns(pl)))
+	if (ns_is_server(ldlm_pl2ns(pl))) {
+		struct ldlm_resource *res = lock->l_resource;
+
+		atomic_long_sub(sizeof(*lock), &pl->pl_granted_bytes);
+		/* the lock is already unlinked from the resource */
+		if (list_empty(&res->lr_granted)) {
+			atomic_long_sub(res->lr_pool_mem,
+					&pl->pl_granted_bytes);
+			res->lr_pool_mem = 0;
+		}
 		ldlm_pool_recalc(pl);
+	}
 }
 EXPORT_SYMBOL(ldlm_pool_del);
 
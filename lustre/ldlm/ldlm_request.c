@@ -1623,6 +1623,10 @@ ldlm_cancel_lru_policy(struct ldlm_namespace *ns, int flags)
  *                               (typically before replaying locks) w/o
  *                               sending any RPCs or waiting for any
  *                               outstanding RPC to complete.
+ *
+ * Except for LDLM_CANCEL_PASSED, LDLM_CANCEL_SHRINK and LDLM_CANCEL_NO_WAIT,
+ * locks which were reused from the LRU are moved to its tail rather than
+ * canceled, see ldlm_namespace::ns_lru_reuse_max.
  */
 static int ldlm_prepare_lru_list(struct ldlm_namespace *ns,
 				 struct list_head *cancels, int count, int max,
@@ -1707,6 +1711,35 @@ static int ldlm_prepare_lru_list(struct ldlm_namespace *ns,
 			continue;
 		}
 
+		/* A lock reused from the LRU gets another pass at the LRU
+		 * tail instead, one per counted reuse, so that locks used
+		 * only once (e.g. by find or rsync walking the tree) go
+		 * before the working set of the application. Explicit
+		 * cancel requests and memory pressure still cancel in plain
+		 * LRU order.
+		 *
+		 * ldlm_lock_add_to_lru_nolock() refreshes l_last_used, so
+		 * the LRU stays in age order for the aged and LRUR policies
+		 * which stop at the first lock to keep. The rotation is not
+		 * charged to @remained: it takes one reuse off the lock, so
+		 * the scan still ends. */
+		if (lock->l_lru_reuse > 0 &&
+		    !(flags & (LDLM_CANCEL_PASSED | LDLM_CANCEL_SHRINK |
+			       LDLM_CANCEL_NO_WAIT))) {
+			spin_lock(&ns->ns_lock);
+			if (!list_empty(&lock->l_lru)) {
+				lock->l_lru_reuse--;
+				ldlm_lock_remove_from_lru_nolock(lock);
+				ldlm_lock_add_to_lru_nolock(lock);
+				remained++;
+			}
+			spin_unlock(&ns->ns_lock);
+			lu_ref_del(&lock->l_reference, __func__, current);
+			LDLM_LOCK_RELEASE(lock);
+			spin_lock(&ns->ns_lock);
+			continue;
+		}
+
 		lock_res_and_lock(lock);
 		/* Check flags again under the lock. */
 		if (ldlm_is_canceling(lock) ||
@@ -364,6 +364,8 @@ static int ldlm_namespace_proc_register(struct ldlm_namespace *ns)
 			     &lprocfs_lru_size_fops);
 		ldlm_add_var(&lock_vars[0], ns_pde, "lru_max_age",
 			     &ns->ns_max_age, &ldlm_rw_uint_fops);
+		ldlm_add_var(&lock_vars[0], ns_pde, "lru_reuse_max",
+			     &ns->ns_lru_reuse_max, &ldlm_rw_uint_fops);
 		ldlm_add_var(&lock_vars[0], ns_pde, "early_lock_cancel",
 			     ns, &lprocfs_elc_fops);
 	} else {
@@ -602,7 +604,8 @@ struct ldlm_namespace *ldlm_namespace_new(struct obd_device *obd, char *name,
                                          CFS_HASH_DEPTH |
                                          CFS_HASH_BIGNAME |
                                          CFS_HASH_SPIN_BKTLOCK |
-                                         CFS_HASH_NO_ITEMREF);
+					 CFS_HASH_NO_ITEMREF |
+					 CFS_HASH_RCU);
         if (ns->ns_rs_hash == NULL)
                 GOTO(out_ns, NULL);
 
@@ -630,6 +633,7 @@ struct ldlm_namespace *ldlm_namespace_new(struct obd_device *obd, char *name,
         ns->ns_nr_unused          = 0;
         ns->ns_max_unused         = LDLM_DEFAULT_LRU_SIZE;
         ns->ns_max_age            = LDLM_DEFAULT_MAX_ALIVE;
+        ns->ns_lru_reuse_max      = LDLM_DEFAULT_LRU_REUSE_MAX;
         ns->ns_ctime_age_limit    = LDLM_CTIME_AGE_LIMIT;
         ns->ns_timeouts           = 0;
         ns->ns_orig_connect_flags = 0;
@@ -1079,7 +1083,26 @@ ldlm_resource_get(struct ldlm_namespace *ns, struct ldlm_resource *parent,
         LASSERT(ns->ns_rs_hash != NULL);
         LASSERT(name->name[0] != 0);
 
-        cfs_hash_bd_get_and_lock(ns->ns_rs_hash, (void *)name, &bd, 0);
+	/* Most lookups find an existing resource, try that without the
+	 * bucket lock first. A resource whose refcount dropped to zero is
+	 * being removed from the hash by ldlm_resource_putref() and must not
+	 * be revived, the locked lookup below does not see it. */
+	cfs_hash_bd_get(ns->ns_rs_hash, (void *)name, &bd);
+	rcu_read_lock();
+	hnode = cfs_hash_bd_lookup_rcu(ns->ns_rs_hash, &bd, (void *)name);
+	if (hnode != NULL) {
+		res = hlist_entry(hnode, struct ldlm_resource, lr_hash);
+		if (!atomic_inc_not_zero(&res->lr_refcount))
+			res = NULL;
+	}
+	rcu_read_unlock();
+	if (res != NULL) {
+		CDEBUG(D_INFO, "getref res: %p count: %d\n", res,
+		       atomic_read(&res->lr_refcount));
+		return res;
+	}
+
+        cfs_hash_bd_lock(ns->ns_rs_hash, &bd, 0);
         hnode = cfs_hash_bd_lookup_locked(ns->ns_rs_hash, &bd, (void *)name);
         if (hnode != NULL) {
                 cfs_hash_bd_unlock(ns->ns_rs_hash, &bd, 0);
@@ -1177,6 +1200,14 @@ static void __ldlm_resource_putref_final(cfs_hash_bd_t *bd,
                 ldlm_namespace_put(nsb->nsb_namespace);
 }
 
+static void ldlm_resource_free_rcu(struct rcu_head *head)
+{
+	struct ldlm_resource *res = container_of(head, struct ldlm_resource,
+						 lr_rcu);
+
+	OBD_SLAB_FREE(res, ldlm_resource_slab, sizeof(*res));
+}
+
 /* Returns 1 if the resource was freed, 0 if it remains. */
 int ldlm_resource_putref(struct ldlm_resource *res)
 {
@@ -1193,7 +1224,8 @@ int ldlm_resource_putref(struct ldlm_resource *res)
 		cfs_hash_bd_unlock(ns->ns_rs_hash, &bd, 1);
 		if (ns->ns_lvbo && ns->ns_lvbo->lvbo_free)
 			ns->ns_lvbo->lvbo_free(res);
-		OBD_SLAB_FREE(res, ldlm_resource_slab, sizeof *res);
+		/* lockless lookups may still be looking at it */
+		call_rcu(&res->lr_rcu, ldlm_resource_free_rcu);
 		return 1;
 	}
 	return 0;
@@ -1223,7 +1255,7 @@ int ldlm_resource_putref_locked(struct ldlm_resource *res)
 		 */
 		if (ns->ns_lvbo && ns->ns_lvbo->lvbo_free)
 			ns->ns_lvbo->lvbo_free(res);
-		OBD_SLAB_FREE(res, ldlm_resource_slab, sizeof *res);
+		call_rcu(&res->lr_rcu, ldlm_resource_free_rcu);
 
 		cfs_hash_bd_lock(ns->ns_rs_hash, &bd, 1);
 		return 1;
@@ -330,6 +330,7 @@ static int ll_md_close(struct obd_export *md_exp, struct inode *inode,
 	}
 
 out:
+	ll_readahead_fini(inode, &fd->fd_ras);
 	LUSTRE_FPRIVATE(file) = NULL;
 	ll_file_data_put(fd);
 	ll_capa_close(inode);
@@ -1240,25 +1241,107 @@ out:
 	return result;
 }
 
+/*
+ * Accounts a read of \a count bytes at \a pos served by ll_do_fast_read() to
+ * read-ahead, as vvp_io_read_page() does for each page read through CLIO, so
+ * that the read-ahead window keeps following a stream whose pages were
+ * already cached. The stream is updated once for the whole request, see
+ * ras_update_range(). The request itself is counted only if it was served
+ * whole, otherwise vvp_io_read_start() counts it.
+ */
+static void ll_fast_read_ras_update(struct file *file, loff_t pos,
+				    size_t count, bool whole)
+{
+	struct inode		*inode = file_inode(file);
+	struct ll_sb_info	*sbi = ll_i2sbi(inode);
+	struct ll_file_data	*fd = LUSTRE_FPRIVATE(file);
+	struct ll_ra_read	 bead;
+	pgoff_t			 first = pos >> PAGE_CACHE_SHIFT;
+	pgoff_t			 last = (pos + count - 1) >> PAGE_CACHE_SHIFT;
+
+	if (sbi->ll_ra_info.ra_max_pages_per_file == 0 ||
+	    sbi->ll_ra_info.ra_max_pages == 0)
+		return;
+
+	if (whole) {
+		bead.lrr_start = first;
+		bead.lrr_count = last - first + 1;
+		ll_ra_read_in(file, &bead);
+	}
+
+	ras_update_range(sbi, inode, &fd->fd_ras, first, last);
+
+	if (whole)
+		ll_ra_read_ex(file, &bead);
+}
+
+/*
+ * Read pages which are uptodate in the page cache without setting up a
+ * cl_io. Pages of a file stay cached only while a DLM lock covers them, lock
+ * cancellation discards them, so no lock needs to be taken to read them.
+ * The read stops at the first page which is not uptodate, see ll_readpage(),
+ * and at i_size, which is not refreshed here. The caller reads the rest
+ * through CLIO.
+ */
+static ssize_t ll_do_fast_read(struct kiocb *iocb, struct iov_iter *iter)
+{
+	struct file		*file = iocb->ki_filp;
+	struct ll_sb_info	*sbi = ll_i2sbi(file_inode(file));
+	loff_t			 pos = iocb->ki_pos;
+	ssize_t			 result;
+
+	/* nolock files, per mount or per file, do not cache under a lock */
+	if (!(sbi->ll_flags & LL_SBI_FAST_READ) || ll_file_nolock(file))
+		return 0;
+
+	/* direct IO has to go through CLIO to take its lock */
+	if (file->f_flags & O_DIRECT)
+		return 0;
+
+	/* turn off the kernel's read-ahead, as vvp_io_read_start() does */
+	file->f_ra.ra_pages = 0;
+
+	result = generic_file_read_iter(iocb, iter);
+	if (result == -ENODATA) {
+		result = 0;
+	} else if (result > 0) {
+		ll_stats_ops_tally(sbi, LPROC_LL_READ_BYTES, result);
+		ll_fast_read_ras_update(file, pos, result,
+					iov_iter_count(iter) == 0);
+	}
+
+	return result;
+}
+
 static ssize_t ll_file_read_iter(struct kiocb *iocb, struct iov_iter *to)
 {
         struct lu_env      *env;
         struct vvp_io_args *args;
         ssize_t             result;
+	ssize_t             rc;
         int                 refcheck;
         ENTRY;
 
+	result = ll_do_fast_read(iocb, to);
+	if (result < 0 || iov_iter_count(to) == 0)
+		RETURN(result);
+
         env = cl_env_get(&refcheck);
         if (IS_ERR(env))
-                RETURN(PTR_ERR(env));
+		RETURN(result > 0 ? result : PTR_ERR(env));
 
         args = vvp_env_args(env, IO_NORMAL);
 	args->u.normal.via_iter = to;
         args->u.normal.via_iocb = iocb;
 
-        result = ll_file_io_generic(env, args, iocb->ki_filp, CIT_READ,
-				    &iocb->ki_pos, iov_iter_count(to));
+	rc = ll_file_io_generic(env, args, iocb->ki_filp, CIT_READ,
+				&iocb->ki_pos, iov_iter_count(to));
+	if (rc > 0)
+		result += rc;
+	else if (result == 0)
+		result = rc;
 
+	cl_env_put(env, &refcheck);
         RETURN(result);
 }
 
@@ -1594,6 +1677,126 @@ static int ll_put_grouplock(struct inode *inode, struct file *file,
 	RETURN(0);
 }
 
+/**
+ * Request extent locks on the file without doing any I/O.
+ *
+ * Each extent is enqueued non-blocking and without expansion, so that
+ * processes writing disjoint regions of a shared file can each get a lock
+ * on exactly their region up front, instead of having the server expand the
+ * first writer's lock over the whole file and then call it back for every
+ * other writer. Granted locks are released into the client lock cache,
+ * where the following I/O matches them.
+ *
+ * The result of each enqueue is returned in lle_result: 0 if the lock was
+ * granted, -EWOULDBLOCK if a conflicting lock exists, or another error.
+ * The ioctl fails with -EOPNOTSUPP if an OST the extents map to does not
+ * support lock ahead (OBD_CONNECT_LOCKAHEAD), as it would expand the locks.
+ */
+static int ll_file_lock_ahead(struct file *file,
+			      struct llapi_lock_ahead_arg __user *arg)
+{
+	struct inode			*inode = file_inode(file);
+	struct cl_object		*obj = ll_i2info(inode)->lli_clob;
+	struct llapi_lock_ahead_arg	 lla;
+	struct llapi_lock_ahead_extent	*extents;
+	struct lu_env			*env;
+	struct cl_io			*io;
+	enum cl_lock_mode		 mode;
+	size_t				 size;
+	int				 refcheck;
+	int				 rc;
+	int				 i;
+	ENTRY;
+
+	if (ll_file_nolock(file))
+		RETURN(-EOPNOTSUPP);
+
+	if (copy_from_user(&lla, arg, sizeof(lla)))
+		RETURN(-EFAULT);
+
+	if (lla.lla_version != LLAPI_LOCK_AHEAD_V1)
+		RETURN(-EINVAL);
+
+	switch (lla.lla_lock_mode) {
+	case LLAPI_LOCK_MODE_READ:
+		mode = CLM_READ;
+		break;
+	case LLAPI_LOCK_MODE_WRITE:
+		mode = CLM_WRITE;
+		break;
+	default:
+		RETURN(-EINVAL);
+	}
+
+	if (lla.lla_extent_count == 0 ||
+	    lla.lla_extent_count > LLAPI_LOCK_AHEAD_MAX_EXTENTS)
+		RETURN(-EINVAL);
+
+	size = lla.lla_extent_count * sizeof(*extents);
+	OBD_ALLOC_LARGE(extents, size);
+	if (extents == NULL)
+		RETURN(-ENOMEM);
+
+	if (copy_from_user(extents, arg->lla_extents, size))
+		GOTO(out_free, rc = -EFAULT);
+
+	for (i = 0; i < lla.lla_extent_count; i++) {
+		if (extents[i].lle_start > extents[i].lle_end)
+			GOTO(out_free, rc = -EINVAL);
+	}
+
+	env = cl_env_get(&refcheck);
+	if (IS_ERR(env))
+		GOTO(out_free, rc = PTR_ERR(env));
+
+	io = ccc_env_thread_io(env);
+	io->ci_obj = obj;
+	io->ci_ignore_layout = 1;
+
+	rc = cl_io_init(env, io, CIT_MISC, obj);
+	if (rc != 0) {
+		/* nothing to lock on a released file */
+		if (rc > 0)
+			rc = -ENODATA;
+		GOTO(out_io, rc);
+	}
+
+	for (i = 0; i < lla.lla_extent_count; i++) {
+		struct cl_lock		*lock = ccc_env_lock(env);
+		struct cl_lock_descr	*descr = &lock->cll_descr;
+
+		descr->cld_obj = obj;
+		descr->cld_mode = mode;
+		descr->cld_start = cl_index(obj, extents[i].lle_start);
+		descr->cld_end = cl_index(obj, extents[i].lle_end);
+		descr->cld_enq_flags = CEF_MUST | CEF_NONBLOCK |
+				       CEF_LOCK_NO_EXPAND;
+
+		extents[i].lle_result = cl_lock_request(env, io, lock);
+		if (extents[i].lle_result == 0)
+			cl_lock_release(env, lock);
+
+		CDEBUG(D_DLMTRACE, DFID": lock ahead ["LPU64", "LPU64"]: %d\n",
+		       PFID(ll_inode2fid(inode)), extents[i].lle_start,
+		       extents[i].lle_end, extents[i].lle_result);
+
+		/* an OST of the file does not support lock ahead */
+		if (extents[i].lle_result == -EOPNOTSUPP)
+			GOTO(out_io, rc = -EOPNOTSUPP);
+	}
+
+	if (copy_to_user(arg->lla_extents, extents, size))
+		rc = -EFAULT;
+
+	EXIT;
+out_io:
+	cl_io_fini(env, io);
+	cl_env_put(env, &refcheck);
+out_free:
+	OBD_FREE_LARGE(extents, size);
+	return rc;
+}
+
 /**
  * Close inode open handle
  *
@@ -2225,6 +2428,9 @@ ll_file_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
                 RETURN(ll_get_grouplock(inode, file, arg));
         case LL_IOC_GROUP_UNLOCK:
                 RETURN(ll_put_grouplock(inode, file, arg));
+	case LL_IOC_LOCK_AHEAD:
+		RETURN(ll_file_lock_ahead(file,
+				(struct llapi_lock_ahead_arg __user *)arg));
         case IOC_OBD_STATFS:
 		RETURN(ll_obd_statfs(inode, (void __user *)arg));
 
@@ -337,18 +337,29 @@ enum ra_stat {
         RA_STAT_MAX_IN_FLIGHT,
         RA_STAT_WRONG_GRAB_PAGE,
 	RA_STAT_FAILED_REACH_END,
+	RA_STAT_ASYNC,
+	RA_STAT_STREAM_NEW,
+	RA_STAT_STREAM_HITS,
+	RA_STAT_STREAM_MISSES,
 	_NR_RA_STAT,
 };
 
+/* default number of read-ahead work items running at once per mount */
+#define SBI_DEFAULT_READAHEAD_ASYNC_ACTIVE	4
+
 struct ll_ra_info {
 	atomic_t	ra_cur_pages;
 	unsigned long	ra_max_pages;
 	unsigned long	ra_max_pages_per_file;
 	unsigned long	ra_max_read_ahead_whole_pages;
+	/* read-ahead work items queued or running */
+	atomic_t	ra_async_inflight;
+	/* limit of ra_async_inflight, 0 disables asynchronous read-ahead */
+	unsigned int	ra_async_max_active;
 };
 
 /* ra_io_arg will be filled in the beginning of ll_readahead with
- * ras_lock, then the following ll_read_ahead_pages will read RA
+ * raf_lock, then the following ll_read_ahead_pages will read RA
  * pages according to this arg, all the items in this structure are
  * counted by page index.
  */
@@ -423,6 +434,7 @@ enum stats_track_type {
 #define LL_SBI_USER_FID2PATH  0x40000 /* allow fid2path by unprivileged users */
 #define LL_SBI_XATTR_CACHE    0x80000 /* support for xattr cache */
 #define LL_SBI_NOROOTSQUASH  0x100000 /* do not apply root squash */
+#define LL_SBI_FAST_READ     0x200000 /* read cached pages without cl_io */
 
 #define LL_SBI_FLAGS { 	\
 	"nolck",	\
@@ -446,6 +458,7 @@ enum stats_track_type {
 	"user_fid2path",\
 	"xattr_cache",	\
 	"norootsquash",	\
+	"fast_read",	\
 }
 
 #define RCE_HASHES      32
@@ -572,13 +585,15 @@ struct ll_ra_read {
         pgoff_t             lrr_count;
         struct task_struct *lrr_reader;
 	struct list_head          lrr_linkage;
+	/* read-ahead stream this read(2) call belongs to */
+	struct ll_readahead_state *lrr_stream;
 };
 
 /*
- * per file-descriptor read-ahead data.
+ * read-ahead data of one stream of accesses to a file; protected by
+ * ll_readahead_file::raf_lock.
  */
 struct ll_readahead_state {
-	spinlock_t  ras_lock;
         /*
          * index of the last page that read(2) needed and that wasn't in the
          * cache. Used by ras_update() to detect seeks.
@@ -631,12 +646,6 @@ struct ll_readahead_state {
          * will not be accurate when dealing with reads issued via mmap.
          */
         unsigned long   ras_request_index;
-        /*
-         * list of struct ll_ra_read's one per read(2) call current in
-         * progress against this file descriptor. Used by read-ahead code,
-         * protected by ->ras_lock.
-         */
-	struct list_head      ras_read_beads;
         /*
          * The following 3 items are used for detecting the stride I/O
          * mode.
@@ -658,12 +667,45 @@ struct ll_readahead_state {
          * stride read-ahead will be enable
          */
         unsigned long   ras_consecutive_stride_requests;
+	/*
+	 * pages of this stream found in cache (hits) or read synchronously
+	 * (misses) since it was started; reported to ll_ra_stats when the
+	 * stream is retired.
+	 */
+	unsigned long	ras_hits;
+	unsigned long	ras_misses;
+	/* ll_readahead_file::raf_clock at the last access, for LRU */
+	unsigned long	ras_last_used;
+	/* stream is in use */
+	unsigned int	ras_active:1;
+};
+
+/* number of read-ahead streams tracked per file descriptor */
+#define LL_RA_STREAMS_MAX	4
+
+/*
+ * per file-descriptor read-ahead data. Accesses are sorted into several
+ * independent streams, so that threads sharing a file descriptor, or a
+ * thread reading a few regions of a file in turn, do not reset each other's
+ * read-ahead window.
+ */
+struct ll_readahead_file {
+	spinlock_t		  raf_lock;
+	/*
+	 * list of struct ll_ra_read's one per read(2) call current in
+	 * progress against this file descriptor. Used by read-ahead code,
+	 * protected by ->raf_lock.
+	 */
+	struct list_head	  raf_read_beads;
+	/* bumped on each stream lookup */
+	unsigned long		  raf_clock;
+	struct ll_readahead_state raf_streams[LL_RA_STREAMS_MAX];
 };
 
 extern struct kmem_cache *ll_file_data_slab;
 struct lustre_handle;
 struct ll_file_data {
-	struct ll_readahead_state fd_ras;
+	struct ll_readahead_file fd_ras;
 	struct ccc_grouplock fd_grouplock;
 	__u64 lfd_pos;
 	__u32 fd_flags;
@@ -806,10 +848,13 @@ void ll_update_times(struct ptlrpc_request *request, struct inode *inode);
 int ll_writepage(struct page *page, struct writeback_control *wbc);
 int ll_writepages(struct address_space *, struct writeback_control *wbc);
 int ll_readpage(struct file *file, struct page *page);
-void ll_readahead_init(struct inode *inode, struct ll_readahead_state *ras);
+void ll_readahead_init(struct inode *inode, struct ll_readahead_file *raf);
+void ll_readahead_fini(struct inode *inode, struct ll_readahead_file *raf);
 int ll_readahead(const struct lu_env *env, struct cl_io *io,
-		 struct cl_page_list *queue, struct ll_readahead_state *ras,
-		 bool hit);
+		 struct cl_page_list *queue, struct ll_file_data *fd,
+		 unsigned long index, bool hit);
+int ll_readahead_sched_init(void);
+void ll_readahead_sched_fini(void);
 int vvp_io_write_commit(const struct lu_env *env, struct cl_io *io);
 struct ll_cl_context *ll_cl_find(struct file *file);
 void ll_cl_add(struct file *file, const struct lu_env *env, struct cl_io *io);
@@ -1251,8 +1296,11 @@ int cl_sb_init(struct super_block *sb);
 int cl_sb_fini(struct super_block *sb);
 
 void ras_update(struct ll_sb_info *sbi, struct inode *inode,
-                struct ll_readahead_state *ras, unsigned long index,
-                unsigned hit);
+		struct ll_readahead_file *raf, unsigned long index,
+		unsigned hit);
+void ras_update_range(struct ll_sb_info *sbi, struct inode *inode,
+		      struct ll_readahead_file *raf, unsigned long start,
+		      unsigned long end);
 void ll_ra_count_put(struct ll_sb_info *sbi, unsigned long len);
 void ll_ra_stats_inc(struct inode *inode, enum ra_stat which);
 
@@ -232,6 +232,39 @@ static ssize_t ll_xattr_cache_seq_write(struct file *file,
 }
 LPROC_SEQ_FOPS(ll_xattr_cache);
 
+static int ll_fast_read_seq_show(struct seq_file *m, void *v)
+{
+	struct ll_sb_info *sbi = ll_s2sbi((struct super_block *)m->private);
+
+	return seq_printf(m, "%u\n", !!(sbi->ll_flags & LL_SBI_FAST_READ));
+}
+
+static ssize_t ll_fast_read_seq_write(struct file *file,
+				      const char __user *buffer,
+				      size_t count, loff_t *off)
+{
+	struct seq_file *m = file->private_data;
+	struct ll_sb_info *sbi = ll_s2sbi((struct super_block *)m->private);
+	int val, rc;
+
+	rc = lprocfs_write_helper(buffer, count, &val);
+	if (rc)
+		return rc;
+
+	if (val != 0 && val != 1)
+		return -ERANGE;
+
+	spin_lock(&sbi->ll_lock);
+	if (val == 1)
+		sbi->ll_flags |= LL_SBI_FAST_READ;
+	else
+		sbi->ll_flags &= ~LL_SBI_FAST_READ;
+	spin_unlock(&sbi->ll_lock);
+
+	return count;
+}
+LPROC_SEQ_FOPS(ll_fast_read);
+
 static int ll_site_stats_seq_show(struct seq_file *m, void *v)
 {
 	struct super_block *sb = m->private;
@@ -384,6 +417,37 @@ ll_max_read_ahead_whole_mb_seq_write(struct file *file,
 }
 LPROC_SEQ_FOPS(ll_max_read_ahead_whole_mb);
 
+static int ll_max_read_ahead_async_active_seq_show(struct seq_file *m,
+						   void *v)
+{
+	struct super_block *sb = m->private;
+	struct ll_sb_info *sbi = ll_s2sbi(sb);
+
+	return seq_printf(m, "%u\n", sbi->ll_ra_info.ra_async_max_active);
+}
+
+static ssize_t
+ll_max_read_ahead_async_active_seq_write(struct file *file,
+					 const char __user *buffer,
+					 size_t count, loff_t *off)
+{
+	struct seq_file *m = file->private_data;
+	struct ll_sb_info *sbi = ll_s2sbi((struct super_block *)m->private);
+	int rc, val;
+
+	rc = lprocfs_write_helper(buffer, count, &val);
+	if (rc)
+		return rc;
+
+	/* 0 turns asynchronous read-ahead off */
+	if (val < 0)
+		return -ERANGE;
+
+	sbi->ll_ra_info.ra_async_max_active = val;
+	return count;
+}
+LPROC_SEQ_FOPS(ll_max_read_ahead_async_active);
+
 static int ll_max_cached_mb_seq_show(struct seq_file *m, void *v)
 {
 	struct super_block     *sb    = m->private;
@@ -986,6 +1050,8 @@ struct lprocfs_seq_vars lprocfs_llite_obd_vars[] = {
 	  .fops	=	&ll_max_readahead_per_file_mb_fops	},
 	{ .name	=	"max_read_ahead_whole_mb",
 	  .fops	=	&ll_max_read_ahead_whole_mb_fops	},
+	{ .name	=	"max_read_ahead_async_active",
+	  .fops	=	&ll_max_read_ahead_async_active_fops	},
 	{ .name	=	"max_cached_mb",
 	  .fops	=	&ll_max_cached_mb_fops			},
 	{ .name	=	"checksum_pages",
@@ -1016,6 +1082,8 @@ struct lprocfs_seq_vars lprocfs_llite_obd_vars[] = {
 	  .fops =	&ll_defult_cookiesize_fops		},
 	{ .name	=	"sbi_flags",
 	  .fops =	&ll_sbi_flags_fops			},
+	{ .name	=	"fast_read",
+	  .fops	=	&ll_fast_read_fops			},
 	{ .name	=	"xattr_cache",
 	  .fops	=	&ll_xattr_cache_fops			},
 	{ .name	=	"unstable_stats",
@@ -1113,7 +1181,11 @@ static const char *ra_stat_string[] = {
 	[RA_STAT_EOF] = "read-ahead to EOF",
 	[RA_STAT_MAX_IN_FLIGHT] = "hit max r-a issue",
 	[RA_STAT_WRONG_GRAB_PAGE] = "wrong page from grab_cache_page",
-	[RA_STAT_FAILED_REACH_END] = "failed to reach end"
+	[RA_STAT_FAILED_REACH_END] = "failed to reach end",
+	[RA_STAT_ASYNC] = "async readahead",
+	[RA_STAT_STREAM_NEW] = "new stream",
+	[RA_STAT_STREAM_HITS] = "stream hits",
+	[RA_STAT_STREAM_MISSES] = "stream misses",
 };
 
 LPROC_SEQ_FOPS_RO_TYPE(llite, name);
@@ -1206,9 +1278,17 @@ int lprocfs_register_mountpoint(struct proc_dir_entry *parent,
         if (sbi->ll_ra_stats == NULL)
                 GOTO(out, err = -ENOMEM);
 
-        for (id = 0; id < ARRAY_SIZE(ra_stat_string); id++)
-                lprocfs_counter_init(sbi->ll_ra_stats, id, 0,
-                                     ra_stat_string[id], "pages");
+	for (id = 0; id < ARRAY_SIZE(ra_stat_string); id++) {
+		/* per-stream counters are added once per retired stream,
+		 * keep their min/max/sum to show the spread over streams */
+		if (id == RA_STAT_STREAM_HITS || id == RA_STAT_STREAM_MISSES)
+			lprocfs_counter_init(sbi->ll_ra_stats, id,
+					     LPROCFS_CNTR_AVGMINMAX,
+					     ra_stat_string[id], "pages");
+		else
+			lprocfs_counter_init(sbi->ll_ra_stats, id, 0,
+					     ra_stat_string[id], "pages");
+	}
         err = lprocfs_register_stats(sbi->ll_proc_root, "read_ahead_stats",
                                      sbi->ll_ra_stats);
         if (err)
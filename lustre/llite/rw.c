@@ -158,13 +158,14 @@ void ll_ra_stats_inc(struct inode *inode, enum ra_stat which)
 #define RAS_CDEBUG(ras) \
         CDEBUG(D_READA,                                                      \
                "lrp %lu cr %lu cp %lu ws %lu wl %lu nra %lu r %lu ri %lu"    \
-               "csr %lu sf %lu sp %lu sl %lu \n",                            \
+               "csr %lu sf %lu sp %lu sl %lu h %lu m %lu\n",                 \
                ras->ras_last_readpage, ras->ras_consecutive_requests,        \
                ras->ras_consecutive_pages, ras->ras_window_start,            \
                ras->ras_window_len, ras->ras_next_readahead,                 \
                ras->ras_requests, ras->ras_request_index,                    \
                ras->ras_consecutive_stride_requests, ras->ras_stride_offset, \
-               ras->ras_stride_pages, ras->ras_stride_length)
+               ras->ras_stride_pages, ras->ras_stride_length,                \
+               ras->ras_hits, ras->ras_misses)
 
 static int index_in_window(unsigned long index, unsigned long point,
                            unsigned long before, unsigned long after)
@@ -179,7 +180,7 @@ static int index_in_window(unsigned long index, unsigned long point,
         return start <= index && index <= end;
 }
 
-static struct ll_readahead_state *ll_ras_get(struct file *f)
+static struct ll_readahead_file *ll_raf_get(struct file *f)
 {
         struct ll_file_data       *fd;
 
@@ -187,38 +188,157 @@ static struct ll_readahead_state *ll_ras_get(struct file *f)
         return &fd->fd_ras;
 }
 
+static void ras_reset(struct inode *inode, struct ll_readahead_state *ras,
+		      unsigned long index);
+static void ras_stride_reset(struct ll_readahead_state *ras);
+
+/* Report the hit and miss counts of a stream that goes away. */
+static void ras_stream_retire(struct ll_sb_info *sbi,
+			      struct ll_readahead_state *ras)
+{
+	if (ras->ras_hits + ras->ras_misses == 0)
+		return;
+
+	lprocfs_counter_add(sbi->ll_ra_stats, RA_STAT_STREAM_HITS,
+			    ras->ras_hits);
+	lprocfs_counter_add(sbi->ll_ra_stats, RA_STAT_STREAM_MISSES,
+			    ras->ras_misses);
+}
+
+/*
+ * How well an access to \a index fits the stream \a ras: 2 if it is close
+ * to the last page read by the stream, 1 if it lies in the stride pattern or
+ * in the read-ahead window of the stream, 0 if it does not belong to it.
+ */
+static int ras_stream_match(struct ll_readahead_state *ras,
+			    unsigned long index)
+{
+	if (!ras->ras_active)
+		return 0;
+
+	if (index_in_window(index, ras->ras_last_readpage, 8, 8))
+		return 2;
+
+	if (ras->ras_consecutive_stride_requests > 0 &&
+	    ras->ras_stride_length > ras->ras_stride_pages &&
+	    ras->ras_stride_pages > 0 && index > ras->ras_last_readpage &&
+	    index - ras->ras_last_readpage - 1 ==
+	    ras->ras_stride_length - ras->ras_stride_pages)
+		return 1;
+
+	if (ras->ras_window_len > 0 &&
+	    index_in_window(index, ras->ras_window_start, 0,
+			    ras->ras_window_len - 1))
+		return 1;
+
+	return 0;
+}
+
+/*
+ * Find the read-ahead stream an access to \a index belongs to.
+ *
+ * An access that belongs to no stream starts a new one in a free slot, or in
+ * place of the least recently used stream. The new stream starts as a copy
+ * of the stream closest behind \a index, so that ras_update() still sees the
+ * jump from that stream and can detect a stride pattern; with a single
+ * reader this behaves exactly like one stream per file descriptor.
+ *
+ * Called with ll_readahead_file::raf_lock held.
+ */
+static struct ll_readahead_state *
+ras_stream_find(struct inode *inode, struct ll_readahead_file *raf,
+		unsigned long index)
+{
+	struct ll_readahead_state *ras;
+	struct ll_readahead_state *best = NULL;
+	struct ll_readahead_state *victim = NULL;
+	struct ll_readahead_state *parent = NULL;
+	int match = 0;
+	int i;
+
+	raf->raf_clock++;
+	for (i = 0; i < LL_RA_STREAMS_MAX; i++) {
+		int rc;
+
+		ras = &raf->raf_streams[i];
+		rc = ras_stream_match(ras, index);
+		if (rc > match) {
+			match = rc;
+			best = ras;
+		}
+
+		if (victim == NULL || (victim->ras_active &&
+		    (!ras->ras_active ||
+		     ras->ras_last_used < victim->ras_last_used)))
+			victim = ras;
+
+		if (ras->ras_active && ras->ras_last_readpage <= index &&
+		    (parent == NULL ||
+		     ras->ras_last_readpage > parent->ras_last_readpage))
+			parent = ras;
+	}
+
+	if (best != NULL) {
+		best->ras_last_used = raf->raf_clock;
+		return best;
+	}
+
+	ll_ra_stats_inc(inode, RA_STAT_STREAM_NEW);
+	if (victim != parent) {
+		if (victim->ras_active)
+			ras_stream_retire(ll_i2sbi(inode), victim);
+
+		if (parent != NULL) {
+			*victim = *parent;
+		} else {
+			ras_reset(inode, victim, index);
+			ras_stride_reset(victim);
+			victim->ras_requests = 0;
+			victim->ras_request_index = 0;
+		}
+		victim->ras_hits = 0;
+		victim->ras_misses = 0;
+	}
+	victim->ras_active = 1;
+	victim->ras_last_used = raf->raf_clock;
+	return victim;
+}
+
 void ll_ra_read_in(struct file *f, struct ll_ra_read *rar)
 {
+	struct ll_readahead_file  *raf;
 	struct ll_readahead_state *ras;
 
-	ras = ll_ras_get(f);
+	raf = ll_raf_get(f);
 
-	spin_lock(&ras->ras_lock);
+	spin_lock(&raf->raf_lock);
+	ras = ras_stream_find(file_inode(f), raf, rar->lrr_start);
 	ras->ras_requests++;
 	ras->ras_request_index = 0;
 	ras->ras_consecutive_requests++;
 	rar->lrr_reader = current;
+	rar->lrr_stream = ras;
 
-	list_add(&rar->lrr_linkage, &ras->ras_read_beads);
-	spin_unlock(&ras->ras_lock);
+	list_add(&rar->lrr_linkage, &raf->raf_read_beads);
+	spin_unlock(&raf->raf_lock);
 }
 
 void ll_ra_read_ex(struct file *f, struct ll_ra_read *rar)
 {
-	struct ll_readahead_state *ras;
+	struct ll_readahead_file *raf;
 
-	ras = ll_ras_get(f);
+	raf = ll_raf_get(f);
 
-	spin_lock(&ras->ras_lock);
+	spin_lock(&raf->raf_lock);
 	list_del_init(&rar->lrr_linkage);
-	spin_unlock(&ras->ras_lock);
+	spin_unlock(&raf->raf_lock);
 }
 
-static struct ll_ra_read *ll_ra_read_get_locked(struct ll_readahead_state *ras)
+static struct ll_ra_read *ll_ra_read_get_locked(struct ll_readahead_file *raf)
 {
         struct ll_ra_read *scan;
 
-	list_for_each_entry(scan, &ras->ras_read_beads, lrr_linkage) {
+	list_for_each_entry(scan, &raf->raf_read_beads, lrr_linkage) {
                 if (scan->lrr_reader == current)
                         return scan;
         }
@@ -227,17 +347,38 @@ static struct ll_ra_read *ll_ra_read_get_locked(struct ll_readahead_state *ras)
 
 struct ll_ra_read *ll_ra_read_get(struct file *f)
 {
-	struct ll_readahead_state *ras;
-	struct ll_ra_read         *bead;
+	struct ll_readahead_file *raf;
+	struct ll_ra_read        *bead;
 
-	ras = ll_ras_get(f);
+	raf = ll_raf_get(f);
 
-	spin_lock(&ras->ras_lock);
-	bead = ll_ra_read_get_locked(ras);
-	spin_unlock(&ras->ras_lock);
+	spin_lock(&raf->raf_lock);
+	bead = ll_ra_read_get_locked(raf);
+	spin_unlock(&raf->raf_lock);
 	return bead;
 }
 
+/*
+ * Return the stream the current access to \a index belongs to: the stream
+ * of the read(2) call in progress, if any, or the one found by
+ * ras_stream_find() for mmap accesses.
+ *
+ * Called with ll_readahead_file::raf_lock held.
+ */
+static struct ll_readahead_state *
+ras_stream_get_locked(struct inode *inode, struct ll_readahead_file *raf,
+		      unsigned long index)
+{
+	struct ll_ra_read *bead = ll_ra_read_get_locked(raf);
+
+	if (bead != NULL && bead->lrr_stream != NULL) {
+		bead->lrr_stream->ras_last_used = ++raf->raf_clock;
+		return bead->lrr_stream;
+	}
+
+	return ras_stream_find(inode, raf, index);
+}
+
 static int cl_read_ahead_page(const struct lu_env *env, struct cl_io *io,
 			      struct cl_page_list *queue, struct cl_page *page,
 			      struct cl_object *clob, pgoff_t *max_index)
@@ -493,19 +634,194 @@ static int ll_read_ahead_pages(const struct lu_env *env,
         return count;
 }
 
+/*
+ * If read-ahead did not get to the end of the region reserved from the
+ * stream, move the stream back so that the next read-ahead tries from where
+ * this one left off. This is only done if the region that was not read is
+ * still ahead of the application and behind the next index to start
+ * read-ahead from.
+ */
+static void ras_rollback(struct ll_readahead_file *raf,
+			 struct ll_readahead_state *ras, unsigned long ra_end)
+{
+	spin_lock(&raf->raf_lock);
+	if (ra_end < ras->ras_next_readahead &&
+	    index_in_window(ra_end, ras->ras_window_start, 0,
+			    ras->ras_window_len)) {
+		ras->ras_next_readahead = ra_end;
+		RAS_CDEBUG(ras);
+	}
+	spin_unlock(&raf->raf_lock);
+}
+
+/* Scheduler running asynchronous read-ahead work items */
+static struct cfs_wi_sched *ll_ra_sched;
+
+/*
+ * Asynchronous read-ahead of a part of the window of a sequential stream,
+ * issued from a work item so that the reader does not pay for building and
+ * sending the read-ahead RPCs.
+ */
+struct ll_readahead_work {
+	cfs_workitem_t			 lrw_wi;
+	/* file the read-ahead is done for, referenced */
+	struct file			*lrw_file;
+	/* stream the window was reserved from */
+	struct ll_readahead_state	*lrw_ras;
+	pgoff_t				 lrw_start;
+	pgoff_t				 lrw_end;
+};
+
+/* Minimal window of a stream for its read-ahead to be issued asynchronously */
+#define RAS_ASYNC_MIN_PAGES(inode) (RAS_INCREASE_STEP(inode) * 2)
+
+static int ll_readahead_handle_work(cfs_workitem_t *wi)
+{
+	struct ll_readahead_work *work = wi->wi_data;
+	struct file		 *file = work->lrw_file;
+	struct inode		 *inode = file_inode(file);
+	struct ll_sb_info	 *sbi = ll_i2sbi(inode);
+	struct cl_object	 *clob = ll_i2info(inode)->lli_clob;
+	struct ra_io_arg	 *ria;
+	struct cl_2queue	 *queue;
+	struct lu_env		 *env;
+	struct cl_io		 *io;
+	unsigned long		  len, reserved, ra_end;
+	int			  refcheck;
+	int			  rc;
+	ENTRY;
+
+	env = cl_env_get(&refcheck);
+	if (IS_ERR(env))
+		GOTO(out, rc = PTR_ERR(env));
+
+	io = ccc_env_thread_io(env);
+	io->ci_obj = clob;
+	io->ci_ignore_layout = 1;
+	rc = cl_io_init(env, io, CIT_MISC, clob);
+	if (rc != 0)
+		GOTO(out_io, rc);
+
+	ria = &vvp_env_info(env)->vti_ria;
+	memset(ria, 0, sizeof(*ria));
+	ria->ria_start = work->lrw_start;
+	ria->ria_end = work->lrw_end;
+	len = ria->ria_end - ria->ria_start + 1;
+
+	reserved = ll_ra_count_get(sbi, ria, len, 0);
+	if (reserved < len)
+		ll_ra_stats_inc(inode, RA_STAT_MAX_IN_FLIGHT);
+
+	queue = &io->ci_queue;
+	cl_2queue_init(queue);
+	ll_read_ahead_pages(env, io, &queue->c2_qin, ria, &reserved, &ra_end);
+	if (reserved != 0)
+		ll_ra_count_put(sbi, reserved);
+
+	if (queue->c2_qin.pl_nr > 0)
+		rc = cl_io_submit_rw(env, io, CRT_READ, queue);
+	cl_page_list_disown(env, io, &queue->c2_qin);
+	cl_2queue_fini(env, queue);
+
+	CDEBUG(D_READA, DFID": async ra %lu/%lu ra_end %lu: rc = %d\n",
+	       PFID(ll_inode2fid(inode)), work->lrw_start, work->lrw_end,
+	       ra_end, rc);
+
+	if (ra_end != work->lrw_end + 1) {
+		ll_ra_stats_inc(inode, RA_STAT_FAILED_REACH_END);
+		ras_rollback(&LUSTRE_FPRIVATE(file)->fd_ras, work->lrw_ras,
+			     ra_end);
+	}
+	EXIT;
+out_io:
+	cl_io_fini(env, io);
+	cl_env_put(env, &refcheck);
+out:
+	atomic_dec(&sbi->ll_ra_info.ra_async_inflight);
+	/* If the reader closed the file meanwhile, this drops the last
+	 * reference: ll_file_release() and the close RPC to the MDS then run
+	 * from this "ll_ra" thread, or from the delayed fput work on kernels
+	 * that defer the final fput of kernel threads. Nothing may be held
+	 * here that the close could wait for. */
+	fput(file);
+	cfs_wi_exit(ll_ra_sched, wi);
+	OBD_FREE_PTR(work);
+	/* the work item is freed, so tell the scheduler not to touch it */
+	return 1;
+}
+
+/*
+ * Hand the read-ahead window [\a start, \a end] of stream \a ras over to a
+ * work item. Returns 0 if the work item was queued, or a negative error if
+ * read-ahead has to be done synchronously.
+ */
+static int ll_readahead_async(struct ll_file_data *fd, struct inode *inode,
+			      struct ll_readahead_state *ras,
+			      pgoff_t start, pgoff_t end)
+{
+	struct ll_ra_info	 *ra = &ll_i2sbi(inode)->ll_ra_info;
+	struct ll_readahead_work *work;
+
+	if (fd->fd_flags & LL_FILE_GROUP_LOCKED)
+		return -EOPNOTSUPP;
+
+	if (atomic_inc_return(&ra->ra_async_inflight) >
+	    ra->ra_async_max_active) {
+		atomic_dec(&ra->ra_async_inflight);
+		return -EBUSY;
+	}
+
+	OBD_ALLOC_PTR(work);
+	if (work == NULL) {
+		atomic_dec(&ra->ra_async_inflight);
+		return -ENOMEM;
+	}
+
+	get_file(fd->fd_file);
+	work->lrw_file = fd->fd_file;
+	work->lrw_ras = ras;
+	work->lrw_start = start;
+	work->lrw_end = end;
+	cfs_wi_init(&work->lrw_wi, work, ll_readahead_handle_work);
+	cfs_wi_schedule(ll_ra_sched, &work->lrw_wi);
+
+	ll_ra_stats_inc(inode, RA_STAT_ASYNC);
+	return 0;
+}
+
+int ll_readahead_sched_init(void)
+{
+	int nthrs;
+
+	nthrs = min(cfs_cpt_weight(cfs_cpt_table, CFS_CPT_ANY), 4);
+	return cfs_wi_sched_create("ll_ra", cfs_cpt_table, CFS_CPT_ANY,
+				   nthrs, &ll_ra_sched);
+}
+
+void ll_readahead_sched_fini(void)
+{
+	if (ll_ra_sched != NULL) {
+		cfs_wi_sched_destroy(ll_ra_sched);
+		ll_ra_sched = NULL;
+	}
+}
+
 int ll_readahead(const struct lu_env *env, struct cl_io *io,
-		 struct cl_page_list *queue, struct ll_readahead_state *ras,
-		 bool hit)
+		 struct cl_page_list *queue, struct ll_file_data *fd,
+		 unsigned long index, bool hit)
 {
 	struct vvp_io *vio = vvp_env_io(env);
 	struct vvp_thread_info *vti = vvp_env_info(env);
 	struct cl_attr *attr = ccc_env_thread_attr(env);
+	struct ll_readahead_file *raf = &fd->fd_ras;
+	struct ll_readahead_state *ras;
 	unsigned long start = 0, end = 0, reserved;
 	unsigned long ra_end, len, mlen = 0;
 	struct inode *inode;
 	struct ll_ra_read *bead;
 	struct ra_io_arg *ria = &vti->vti_ria;
 	struct cl_object *clob;
+	bool async = false;
 	int ret = 0;
 	__u64 kms;
 	ENTRY;
@@ -527,12 +843,17 @@ int ll_readahead(const struct lu_env *env, struct cl_io *io,
 		RETURN(0);
 	}
 
-	spin_lock(&ras->ras_lock);
+	spin_lock(&raf->raf_lock);
         if (vio->cui_ra_window_set)
                 bead = &vio->cui_bead;
         else
                 bead = NULL;
 
+	if (bead != NULL && bead->lrr_stream != NULL)
+		ras = bead->lrr_stream;
+	else
+		ras = ras_stream_find(inode, raf, index);
+
         /* Enlarge the RA window to encompass the full read */
         if (bead != NULL && ras->ras_window_start + ras->ras_window_len <
             bead->lrr_start + bead->lrr_count) {
@@ -590,7 +911,14 @@ int ll_readahead(const struct lu_env *env, struct cl_io *io,
                 ria->ria_length = ras->ras_stride_length;
                 ria->ria_pages = ras->ras_stride_pages;
         }
-	spin_unlock(&ras->ras_lock);
+
+	/* A sequential stream hitting its read-ahead pages with a window of
+	 * some size is likely to keep going, issue its read-ahead in the
+	 * background rather than in the context of the reader. */
+	if (hit && end != 0 && !stride_io_mode(ras) &&
+	    ras->ras_window_len >= RAS_ASYNC_MIN_PAGES(inode))
+		async = true;
+	spin_unlock(&raf->raf_lock);
 
 	if (end == 0) {
 		ll_ra_stats_inc(inode, RA_STAT_ZERO_WINDOW);
@@ -602,6 +930,10 @@ int ll_readahead(const struct lu_env *env, struct cl_io *io,
 		RETURN(0);
 	}
 
+	if (async && ll_readahead_async(fd, inode, ras, ria->ria_start,
+					ria->ria_end) == 0)
+		RETURN(0);
+
 	CDEBUG(D_READA, DFID": ria: %lu/%lu, bead: %lu/%lu, hit: %d\n",
 	       PFID(lu_object_fid(&clob->co_lu)),
 	       ria->ria_start, ria->ria_end,
@@ -646,14 +978,7 @@ int ll_readahead(const struct lu_env *env, struct cl_io *io,
 
 	if (ra_end != end + 1) {
 		ll_ra_stats_inc(inode, RA_STAT_FAILED_REACH_END);
-		spin_lock(&ras->ras_lock);
-		if (ra_end < ras->ras_next_readahead &&
-		    index_in_window(ra_end, ras->ras_window_start, 0,
-				    ras->ras_window_len)) {
-			ras->ras_next_readahead = ra_end;
-			RAS_CDEBUG(ras);
-		}
-		spin_unlock(&ras->ras_lock);
+		ras_rollback(raf, ras, ra_end);
 	}
 
 	RETURN(ret);
@@ -665,7 +990,7 @@ static void ras_set_start(struct inode *inode, struct ll_readahead_state *ras,
 	ras->ras_window_start = index & (~(RAS_INCREASE_STEP(inode) - 1));
 }
 
-/* called with the ras_lock held or from places where it doesn't matter */
+/* called with the raf_lock held or from places where it doesn't matter */
 static void ras_reset(struct inode *inode, struct ll_readahead_state *ras,
 		      unsigned long index)
 {
@@ -679,7 +1004,7 @@ static void ras_reset(struct inode *inode, struct ll_readahead_state *ras,
 	RAS_CDEBUG(ras);
 }
 
-/* called with the ras_lock held or from places where it doesn't matter */
+/* called with the raf_lock held or from places where it doesn't matter */
 static void ras_stride_reset(struct ll_readahead_state *ras)
 {
         ras->ras_consecutive_stride_requests = 0;
@@ -688,12 +1013,32 @@ static void ras_stride_reset(struct ll_readahead_state *ras)
         RAS_CDEBUG(ras);
 }
 
-void ll_readahead_init(struct inode *inode, struct ll_readahead_state *ras)
+void ll_readahead_init(struct inode *inode, struct ll_readahead_file *raf)
 {
-	spin_lock_init(&ras->ras_lock);
-	ras_reset(inode, ras, 0);
-	ras->ras_requests = 0;
-	INIT_LIST_HEAD(&ras->ras_read_beads);
+	int i;
+
+	spin_lock_init(&raf->raf_lock);
+	INIT_LIST_HEAD(&raf->raf_read_beads);
+	raf->raf_clock = 0;
+	for (i = 0; i < LL_RA_STREAMS_MAX; i++) {
+		struct ll_readahead_state *ras = &raf->raf_streams[i];
+
+		memset(ras, 0, sizeof(*ras));
+		ras_reset(inode, ras, 0);
+	}
+	/* the first stream covers the start of the file */
+	raf->raf_streams[0].ras_active = 1;
+}
+
+void ll_readahead_fini(struct inode *inode, struct ll_readahead_file *raf)
+{
+	int i;
+
+	for (i = 0; i < LL_RA_STREAMS_MAX; i++) {
+		if (raf->raf_streams[i].ras_active)
+			ras_stream_retire(ll_i2sbi(inode),
+					  &raf->raf_streams[i]);
+	}
 }
 
 /*
@@ -809,17 +1154,20 @@ static void ras_increase_window(struct inode *inode,
 					  ra->ra_max_pages_per_file);
 }
 
-void ras_update(struct ll_sb_info *sbi, struct inode *inode,
-		struct ll_readahead_state *ras, unsigned long index,
-		unsigned hit)
+/* called with the raf_lock held */
+static void ras_update_locked(struct ll_sb_info *sbi, struct inode *inode,
+			      struct ll_readahead_state *ras,
+			      unsigned long index, unsigned hit)
 {
 	struct ll_ra_info *ra = &sbi->ll_ra_info;
 	int zero = 0, stride_detect = 0, ra_miss = 0;
 	ENTRY;
 
-	spin_lock(&ras->ras_lock);
-
         ll_ra_stats_inc_sbi(sbi, hit ? RA_STAT_HIT : RA_STAT_MISS);
+	if (hit)
+		ras->ras_hits++;
+	else
+		ras->ras_misses++;
 
         /* reset the read-ahead window in two cases.  First when the app seeks
          * or reads to some other part of the file.  Secondly if we get a
@@ -859,7 +1207,7 @@ void ras_update(struct ll_sb_info *sbi, struct inode *inode,
                         ras->ras_next_readahead = 0;
                         ras->ras_window_len = min(ra->ra_max_pages_per_file,
                                 ra->ra_max_read_ahead_whole_pages);
-                        GOTO(out_unlock, 0);
+                        GOTO(out, 0);
                 }
         }
 	if (zero) {
@@ -874,7 +1222,7 @@ void ras_update(struct ll_sb_info *sbi, struct inode *inode,
 			}
 			ras_reset(inode, ras, index);
 			ras->ras_consecutive_pages++;
-			GOTO(out_unlock, 0);
+			GOTO(out, 0);
 		} else {
 			ras->ras_consecutive_pages = 0;
 			ras->ras_consecutive_requests = 0;
@@ -899,7 +1247,7 @@ void ras_update(struct ll_sb_info *sbi, struct inode *inode,
 				ras_reset(inode, ras, index);
 				ras->ras_consecutive_pages++;
 				ras_stride_reset(ras);
-				GOTO(out_unlock, 0);
+				GOTO(out, 0);
 			}
 		} else if (stride_io_mode(ras)) {
 			/* If this is contiguous read but in stride I/O mode
@@ -934,7 +1282,7 @@ void ras_update(struct ll_sb_info *sbi, struct inode *inode,
 	 * is not incremented and thus can't be used to trigger RA */
 	if (!ras->ras_window_len && ras->ras_consecutive_pages == 4) {
 		ras->ras_window_len = RAS_INCREASE_STEP(inode);
-		GOTO(out_unlock, 0);
+		GOTO(out, 0);
 	}
 
 	/* Initially reset the stride window offset to next_readahead*/
@@ -955,11 +1303,58 @@ void ras_update(struct ll_sb_info *sbi, struct inode *inode,
 	    !ras->ras_request_index)
 		ras_increase_window(inode, ras, ra);
 	EXIT;
-out_unlock:
+out:
 	RAS_CDEBUG(ras);
 	ras->ras_request_index++;
-	spin_unlock(&ras->ras_lock);
-	return;
+}
+
+void ras_update(struct ll_sb_info *sbi, struct inode *inode,
+		struct ll_readahead_file *raf, unsigned long index,
+		unsigned hit)
+{
+	struct ll_readahead_state *ras;
+
+	spin_lock(&raf->raf_lock);
+	ras = ras_stream_get_locked(inode, raf, index);
+	ras_update_locked(sbi, inode, ras, index, hit);
+	spin_unlock(&raf->raf_lock);
+}
+
+/*
+ * Same as calling ras_update() for every page in [\a start, \a end], all of
+ * which were cache hits, but with the stream looked up and fully updated
+ * only for the first and the last page. The pages in between are
+ * consecutive hits, which only move the stream forward.
+ */
+void ras_update_range(struct ll_sb_info *sbi, struct inode *inode,
+		      struct ll_readahead_file *raf, unsigned long start,
+		      unsigned long end)
+{
+	struct ll_readahead_state *ras;
+	unsigned long nr = 0;
+
+	spin_lock(&raf->raf_lock);
+	ras = ras_stream_get_locked(inode, raf, start);
+	ras_update_locked(sbi, inode, ras, start, 1);
+	if (end > start + 1) {
+		nr = end - start - 1;
+		ras->ras_hits += nr;
+		ras->ras_request_index += nr;
+		ras->ras_last_readpage = end - 1;
+		/* the mmap trigger of ras_update_locked() on the 4th page */
+		if (ras->ras_window_len == 0 &&
+		    ras->ras_consecutive_pages < 4 &&
+		    ras->ras_consecutive_pages + nr >= 4)
+			ras->ras_window_len = RAS_INCREASE_STEP(inode);
+		ras->ras_consecutive_pages += nr;
+	}
+	if (end > start)
+		ras_update_locked(sbi, inode, ras, end, 1);
+	spin_unlock(&raf->raf_lock);
+
+	/* "hits" counts pages, as with ras_update() */
+	while (nr-- > 0)
+		ll_ra_stats_inc_sbi(sbi, RA_STAT_HIT);
 }
 
 int ll_writepage(struct page *vmpage, struct writeback_control *wbc)
@@ -1164,8 +1559,10 @@ int ll_readpage(struct file *file, struct page *vmpage)
 
 	lcc = ll_cl_find(file);
 	if (lcc == NULL) {
+		/* no cl_io, called for a page which is not uptodate by
+		 * ll_do_fast_read(), which continues through CLIO */
 		unlock_page(vmpage);
-		RETURN(-EIO);
+		RETURN(-ENODATA);
 	}
 
 	env = lcc->lcc_env;
@@ -231,26 +231,26 @@ static void ll_free_user_pages(struct page **pages, int npages, int do_dirty)
 	kvfree(pages);
 }
 
-ssize_t ll_direct_rw_pages(const struct lu_env *env, struct cl_io *io,
-                           int rw, struct inode *inode,
-                           struct ll_dio_pages *pv)
+/*
+ * Own the cl_pages for the user pages of \a pv and queue those that need a
+ * transfer into \a queue.
+ */
+static int ll_direct_rw_pages_prep(const struct lu_env *env, struct cl_io *io,
+				   int rw, struct ll_dio_pages *pv,
+				   struct cl_2queue *queue)
 {
 	struct cl_page    *clp;
-	struct cl_2queue  *queue;
 	struct cl_object  *obj = io->ci_obj;
 	int i;
-	ssize_t rc = 0;
+	int rc = 0;
 	loff_t file_offset  = pv->ldp_start_offset;
 	size_t size         = pv->ldp_size;
 	int page_count      = pv->ldp_nr;
 	struct page **pages = pv->ldp_pages;
 	size_t page_size    = cl_page_size(obj);
 	bool do_io;
-	int  io_pages       = 0;
 	ENTRY;
 
-        queue = &io->ci_queue;
-        cl_2queue_init(queue);
         for (i = 0; i < page_count; i++) {
                 if (pv->ldp_offsets)
                     file_offset = pv->ldp_offsets[i];
@@ -312,8 +312,6 @@ ssize_t ll_direct_rw_pages(const struct lu_env *env, struct cl_io *io,
                          * that page has to be sent even if it is beyond KMS.
                          */
                         cl_page_clip(env, clp, 0, min(size, page_size));
-
-                        ++io_pages;
                 }
 
                 /* drop the reference count for cl_page_find */
@@ -321,8 +319,20 @@ ssize_t ll_direct_rw_pages(const struct lu_env *env, struct cl_io *io,
                 size -= page_size;
                 file_offset += page_size;
         }
+	RETURN(rc);
+}
 
-        if (rc == 0 && io_pages) {
+ssize_t ll_direct_rw_pages(const struct lu_env *env, struct cl_io *io,
+                           int rw, struct inode *inode,
+                           struct ll_dio_pages *pv)
+{
+	struct cl_2queue  *queue = &io->ci_queue;
+	ssize_t            rc;
+	ENTRY;
+
+	cl_2queue_init(queue);
+	rc = ll_direct_rw_pages_prep(env, io, rw, pv, queue);
+	if (rc == 0 && queue->c2_qin.pl_nr > 0) {
                 rc = cl_io_submit_sync(env, io,
                                        rw == READ ? CRT_READ : CRT_WRITE,
 				       queue, 0);
@@ -337,20 +347,104 @@ ssize_t ll_direct_rw_pages(const struct lu_env *env, struct cl_io *io,
 }
 EXPORT_SYMBOL(ll_direct_rw_pages);
 
-static ssize_t ll_direct_IO_26_seg(const struct lu_env *env, struct cl_io *io,
-				   int rw, struct inode *inode,
-				   struct address_space *mapping,
-				   size_t size, loff_t file_offset,
-				   struct page **pages, int page_count)
+/**
+ * A segment of a direct IO, whose transfer may still be in flight while the
+ * following segments are prepared and submitted.
+ */
+struct ll_dio_seg {
+	/** linkage into the in-flight segments of ll_direct_IO_26() */
+	struct list_head	 lds_list;
+	/** pages owned for the transfer */
+	struct cl_2queue	 lds_queue;
+	/** completion of the pages in lds_queue */
+	struct cl_sync_io	 lds_anchor;
+	/** pinned user pages */
+	struct page		**lds_pages;
+	int			 lds_nr;
+	/** # bytes of the segment */
+	ssize_t			 lds_size;
+};
+
+/* Min # of segments of a direct IO kept in flight, see ll_dio_max_inflight() */
+#define LL_DIO_MIN_INFLIGHT	8
+
+/*
+ * Submit the transfer of \a seg without waiting for it, so that RPCs for
+ * several segments are in flight on all stripes at the same time.
+ */
+static int ll_dio_seg_submit(const struct lu_env *env, struct cl_io *io,
+			     int rw, struct ll_dio_seg *seg, loff_t file_offset)
+{
+	struct ll_dio_pages	 pvec = { .ldp_pages	    = seg->lds_pages,
+					  .ldp_nr	    = seg->lds_nr,
+					  .ldp_size	    = seg->lds_size,
+					  .ldp_offsets	    = NULL,
+					  .ldp_start_offset = file_offset
+					};
+	struct cl_2queue	*queue = &seg->lds_queue;
+	struct cl_page		*pg;
+	int			 rc;
+	ENTRY;
+
+	cl_2queue_init(queue);
+	rc = ll_direct_rw_pages_prep(env, io, rw, &pvec, queue);
+	if (rc != 0 || queue->c2_qin.pl_nr == 0) {
+		/* nothing to wait for */
+		cl_sync_io_init(&seg->lds_anchor, 0, &cl_sync_io_end);
+		RETURN(rc);
+	}
+
+	cl_page_list_for_each(pg, &queue->c2_qin) {
+		LASSERT(pg->cp_sync_io == NULL);
+		pg->cp_sync_io = &seg->lds_anchor;
+	}
+	cl_sync_io_init(&seg->lds_anchor, queue->c2_qin.pl_nr,
+			&cl_sync_io_end);
+
+	rc = cl_io_submit_rw(env, io, rw == READ ? CRT_READ : CRT_WRITE,
+			     queue);
+	if (rc == 0) {
+		/* pages not sent are completed, see cl_io_submit_sync() */
+		cl_page_list_for_each(pg, &queue->c2_qin) {
+			pg->cp_sync_io = NULL;
+			cl_sync_io_note(env, &seg->lds_anchor, 1);
+		}
+	} else {
+		LASSERT(list_empty(&queue->c2_qout.pl_pages));
+		cl_page_list_for_each(pg, &queue->c2_qin)
+			pg->cp_sync_io = NULL;
+		cl_sync_io_init(&seg->lds_anchor, 0, &cl_sync_io_end);
+	}
+
+	RETURN(rc);
+}
+
+/*
+ * Wait for the transfer of \a seg and release it.
+ *
+ * \retval	# bytes transferred
+ * \retval	-ve on failure
+ */
+static ssize_t ll_dio_seg_finish(const struct lu_env *env, struct cl_io *io,
+				 int rw, struct ll_dio_seg *seg)
 {
-    struct ll_dio_pages pvec = { .ldp_pages        = pages,
-                                 .ldp_nr           = page_count,
-                                 .ldp_size         = size,
-                                 .ldp_offsets      = NULL,
-                                 .ldp_start_offset = file_offset
-                               };
-
-    return ll_direct_rw_pages(env, io, rw, inode, &pvec);
+	struct cl_2queue	*queue = &seg->lds_queue;
+	ssize_t			 rc;
+
+	list_del_init(&seg->lds_list);
+
+	rc = cl_sync_io_wait(env, &seg->lds_anchor, 0);
+	cl_page_list_assume(env, io, &queue->c2_qout);
+	if (rc == 0)
+		rc = seg->lds_size;
+
+	cl_2queue_discard(env, io, queue);
+	cl_2queue_disown(env, io, queue);
+	cl_2queue_fini(env, queue);
+	ll_free_user_pages(seg->lds_pages, seg->lds_nr, rw == READ);
+	OBD_FREE_PTR(seg);
+
+	return rc;
 }
 
 #ifdef KMALLOC_MAX_SIZE
@@ -366,6 +460,31 @@ static ssize_t ll_direct_IO_26_seg(const struct lu_env *env, struct cl_io *io,
  * up to 22MB for 128kB kmalloc and up to 682MB for 4MB kmalloc. */
 #define MAX_DIO_SIZE ((MAX_MALLOC / sizeof(struct brw_page) * PAGE_CACHE_SIZE) & \
 		      ~(DT_MAX_BRW_SIZE - 1))
+
+/* Size of a direct IO segment: a full RPC, so that with the segments in
+ * flight all the stripes are kept busy, while the user pages pinned at any
+ * time stay bounded. */
+#define LL_DIO_SEG_SIZE min_t(long, MAX_DIO_SIZE, DT_MAX_BRW_SIZE)
+
+/*
+ * Returns the # of segments of a direct IO to \a inode kept in flight: at
+ * least one per stripe, so that a widely striped file has an RPC in flight
+ * on every OST, but no more user pages pinned than the MAX_DIO_SIZE chunks
+ * that used to be submitted at once.
+ */
+static int ll_dio_max_inflight(struct inode *inode)
+{
+	struct lov_stripe_md	*lsm = ccc_inode_lsm_get(inode);
+	int			 nr = LL_DIO_MIN_INFLIGHT;
+
+	if (lsm != NULL) {
+		nr = max_t(int, nr, lsm->lsm_stripe_count);
+		ccc_inode_lsm_put(inode, lsm);
+	}
+
+	return min_t(int, nr, max_t(int, MAX_DIO_SIZE / LL_DIO_SEG_SIZE, 1));
+}
+
 static ssize_t ll_direct_IO_26(int rw, struct kiocb *iocb,
 			       struct iov_iter *iter, loff_t file_offset)
 {
@@ -376,7 +495,13 @@ static ssize_t ll_direct_IO_26(int rw, struct kiocb *iocb,
 	ssize_t count = iov_iter_count(iter);
 	ssize_t tot_bytes = 0, result = 0;
         struct ll_inode_info *lli = ll_i2info(inode);
-        long size = MAX_DIO_SIZE;
+	struct ll_dio_seg *seg;
+	struct list_head segs;
+	ssize_t rc;
+	bool failed = false;
+	int inflight = 0;
+	int max_inflight;
+	long size = LL_DIO_SEG_SIZE;
         int refcheck;
         ENTRY;
 
@@ -402,8 +527,12 @@ static ssize_t ll_direct_IO_26(int rw, struct kiocb *iocb,
         io = ccc_env_io(env)->cui_cl.cis_io;
         LASSERT(io != NULL);
 
+	/* FIXME: an AIO kiocb is still completed before returning; it would
+	 * have to be completed by the last segment transfer instead, which
+	 * needs the cl_pages to be released outside of this cl_io. */
+	max_inflight = ll_dio_max_inflight(inode);
+	INIT_LIST_HEAD(&segs);
 	while (iov_iter_count(iter)) {
-		struct page **pages;
 		size_t offs;
 
 		count = min_t(size_t, iov_iter_count(iter), size);
@@ -415,14 +544,42 @@ static ssize_t ll_direct_IO_26(int rw, struct kiocb *iocb,
 
                 }
 
-		result = iov_iter_get_pages_alloc(iter, &pages, count, &offs);
+		/* keep at most max_inflight segments in flight */
+		if (inflight == max_inflight) {
+			seg = list_entry(segs.next, struct ll_dio_seg,
+					 lds_list);
+			rc = ll_dio_seg_finish(env, io, rw, seg);
+			inflight--;
+			if (rc < 0) {
+				failed = true;
+				GOTO(out, result = rc);
+			}
+			tot_bytes += rc;
+		}
+
+		OBD_ALLOC_PTR(seg);
+		if (seg == NULL)
+			GOTO(out, result = -ENOMEM);
+		INIT_LIST_HEAD(&seg->lds_list);
+
+		result = iov_iter_get_pages_alloc(iter, &seg->lds_pages, count,
+						  &offs);
 		if (likely(result > 0)) {
-			int n = (result + offs + PAGE_SIZE - 1) / PAGE_SIZE;
-			result = ll_direct_IO_26_seg(env, io, rw, inode,
-						     file->f_mapping,
-						     result, file_offset,
-						     pages, n);
-			ll_free_user_pages(pages, n, rw==READ);
+			seg->lds_nr = (result + offs + PAGE_SIZE - 1) /
+				      PAGE_SIZE;
+			seg->lds_size = result;
+			rc = ll_dio_seg_submit(env, io, rw, seg, file_offset);
+			if (unlikely(rc != 0)) {
+				/* nothing was queued, so the segment is only
+				 * released here; the bytes of the segments
+				 * already in flight are still returned */
+				ll_dio_seg_finish(env, io, rw, seg);
+				GOTO(out, result = rc);
+			}
+			list_add_tail(&seg->lds_list, &segs);
+			inflight++;
+		} else {
+			OBD_FREE_PTR(seg);
 		}
 		if (unlikely(result <= 0)) {
 			/* If we can't allocate a large enough buffer
@@ -431,7 +588,7 @@ static ssize_t ll_direct_IO_26(int rw, struct kiocb *iocb,
 			 * We should always be able to kmalloc for a
 			 * page worth of page pointers = 4MB on i386. */
 			if (result == -ENOMEM &&
-  			  size > (PAGE_CACHE_SIZE / sizeof(*pages)) *
+			    size > (PAGE_CACHE_SIZE / sizeof(struct page *)) *
 					PAGE_CACHE_SIZE) {
 				size = ((((size / 2) - 1) |
 					~CFS_PAGE_MASK) + 1) &
@@ -444,10 +601,22 @@ static ssize_t ll_direct_IO_26(int rw, struct kiocb *iocb,
 			GOTO(out, result);
                 }
 		iov_iter_advance(iter, result);
-		tot_bytes += result;
 		file_offset += result;
         }
 out:
+	/* only the bytes up to the first failed segment are accounted */
+	while (!list_empty(&segs)) {
+		seg = list_entry(segs.next, struct ll_dio_seg, lds_list);
+		rc = ll_dio_seg_finish(env, io, rw, seg);
+		if (failed)
+			continue;
+		if (rc < 0) {
+			failed = true;
+			result = rc;
+		} else {
+			tot_bytes += rc;
+		}
+	}
 
         if (tot_bytes > 0) {
 		struct ccc_io *cio = ccc_env_io(env);
@@ -180,12 +180,18 @@ static int __init init_lustre_lite(void)
 	if (rc != 0)
 		GOTO(out_vvp, rc);
 
+	rc = ll_readahead_sched_init();
+	if (rc != 0)
+		GOTO(out_xattr, rc);
+
 	lustre_register_client_fill_super(ll_fill_super);
 	lustre_register_kill_super_cb(ll_kill_super);
 	lustre_register_client_process_config(ll_process_config);
 
 	RETURN(0);
 
+out_xattr:
+	ll_xattr_fini();
 out_vvp:
 	vvp_global_fini();
 out_capa:
@@ -217,6 +223,7 @@ static void __exit exit_lustre_lite(void)
 
 	lprocfs_remove(&proc_lustre_fs_root);
 
+	ll_readahead_sched_fini();
 	ll_xattr_fini();
 	vvp_global_fini();
 	del_timer(&ll_capa_timer);
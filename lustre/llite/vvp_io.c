@@ -1059,14 +1059,13 @@ static int vvp_io_read_page(const struct lu_env *env,
 	struct inode              *inode  = vvp_object_inode(slice->cpl_obj);
 	struct ll_sb_info         *sbi    = ll_i2sbi(inode);
 	struct ll_file_data       *fd     = cl2ccc_io(env, ios)->cui_fd;
-	struct ll_readahead_state *ras    = &fd->fd_ras;
 	struct cl_2queue          *queue  = &io->ci_queue;
 
 	ENTRY;
 
 	if (sbi->ll_ra_info.ra_max_pages_per_file > 0 &&
 	    sbi->ll_ra_info.ra_max_pages > 0)
-		ras_update(sbi, inode, ras, vvp_index(vpg),
+		ras_update(sbi, inode, &fd->fd_ras, vvp_index(vpg),
 			   vpg->vpg_defer_uptodate);
 
 	if (vpg->vpg_defer_uptodate) {
@@ -1081,7 +1080,7 @@ static int vvp_io_read_page(const struct lu_env *env,
 	cl_2queue_add(queue, page);
 	if (sbi->ll_ra_info.ra_max_pages_per_file > 0 &&
 	    sbi->ll_ra_info.ra_max_pages > 0)
-		ll_readahead(env, io, &queue->c2_qin, ras,
+		ll_readahead(env, io, &queue->c2_qin, fd, vvp_index(vpg),
 			     vpg->vpg_defer_uptodate);
 
 	RETURN(0);
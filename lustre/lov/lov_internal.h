@@ -190,6 +190,10 @@ int lov_process_config_base(struct obd_device *obd, struct lustre_cfg *lcfg,
 int lov_del_target(struct obd_device *obd, __u32 index,
                    struct obd_uuid *uuidp, int gen);
 
+/* lov_io.c */
+int lov_io_submit_init(void);
+void lov_io_submit_fini(void);
+
 /* lov_pack.c */
 int lov_packmd(struct obd_export *exp, struct lov_mds_md **lmm,
                struct lov_stripe_md *lsm);
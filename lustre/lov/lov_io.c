@@ -575,6 +575,202 @@ static void lov_io_unlock(const struct lu_env *env,
         EXIT;
 }
 
+/*
+ * Parallel submission of pages spanning many stripes.
+ *
+ * Submitting the pages of a stripe builds its extents and queues its RPCs,
+ * which for a widely striped file done one stripe after the other makes a
+ * single writer CPU bound long before the OSTs are. When a queue spans at
+ * least lov_submit_parallel stripes, its pages are sorted by stripe and each
+ * stripe is submitted by a worker thread of the CPU partition of the
+ * submitter, which waits for all of them.
+ */
+static unsigned int lov_submit_parallel = 4;
+CFS_MODULE_PARM(lov_submit_parallel, "i", uint, 0644,
+		"minimal number of stripes a page submission has to span to be "
+		"done by worker threads, 0 to disable");
+
+/* maximal number of submission threads per CPU partition */
+#define LOV_SUBMIT_THREADS_MAX	8
+
+/* per-CPT schedulers of submission threads */
+static struct cfs_wi_sched **lov_submit_scheds;
+
+struct lov_submit_sync {
+	atomic_t		 lss_count;
+	struct completion	 lss_done;
+};
+
+struct lov_submit_job {
+	cfs_workitem_t		 lsj_wi;
+	struct cfs_wi_sched	*lsj_sched;
+	struct lov_submit_sync	*lsj_sync;
+	struct lov_io_sub	*lsj_sub;
+	struct cl_2queue	 lsj_queue;
+	enum cl_req_type	 lsj_crt;
+	struct task_struct	*lsj_owner;
+	int			 lsj_rc;
+};
+
+/* Hand the page lists of \a job over to the thread running it */
+static void lov_submit_job_own(struct lov_submit_job *job,
+			       struct task_struct *task)
+{
+	job->lsj_queue.c2_qin.pl_owner = task;
+	job->lsj_queue.c2_qout.pl_owner = task;
+}
+
+static int lov_submit_job_handler(cfs_workitem_t *wi)
+{
+	struct lov_submit_job	*job = wi->wi_data;
+	struct lov_submit_sync	*sync = job->lsj_sync;
+
+	lov_submit_job_own(job, current);
+	job->lsj_rc = cl_io_submit_rw(job->lsj_sub->sub_env,
+				      job->lsj_sub->sub_io, job->lsj_crt,
+				      &job->lsj_queue);
+	lov_submit_job_own(job, job->lsj_owner);
+
+	cfs_wi_exit(job->lsj_sched, wi);
+	/* the submitter frees @job as soon as the last job is done */
+	if (atomic_dec_and_test(&sync->lss_count))
+		complete(&sync->lss_done);
+	return 1;
+}
+
+int lov_io_submit_init(void)
+{
+	int ncpts = cfs_cpt_number(cfs_cpt_table);
+	int rc;
+	int i;
+
+	OBD_ALLOC(lov_submit_scheds, ncpts * sizeof(lov_submit_scheds[0]));
+	if (lov_submit_scheds == NULL)
+		return -ENOMEM;
+
+	for (i = 0; i < ncpts; i++) {
+		int nthrs = min(cfs_cpt_weight(cfs_cpt_table, i),
+				LOV_SUBMIT_THREADS_MAX);
+
+		rc = cfs_wi_sched_create("lov_sub", cfs_cpt_table, i,
+					 nthrs, &lov_submit_scheds[i]);
+		if (rc != 0) {
+			lov_io_submit_fini();
+			return rc;
+		}
+	}
+	return 0;
+}
+
+void lov_io_submit_fini(void)
+{
+	int ncpts = cfs_cpt_number(cfs_cpt_table);
+	int i;
+
+	if (lov_submit_scheds == NULL)
+		return;
+
+	for (i = 0; i < ncpts; i++) {
+		if (lov_submit_scheds[i] != NULL)
+			cfs_wi_sched_destroy(lov_submit_scheds[i]);
+	}
+	OBD_FREE(lov_submit_scheds, ncpts * sizeof(lov_submit_scheds[0]));
+	lov_submit_scheds = NULL;
+}
+
+/*
+ * Submit the pages of \a queue sorted by stripe, one job per stripe. The
+ * jobs run in worker threads if there are at least lov_submit_parallel of
+ * them, in the calling thread otherwise. Pages that could not be submitted
+ * are left in \a queue::c2_qin as by the serial loop of lov_io_submit().
+ * \a jobs is an array of lis_stripe_count zeroed entries, freed on return.
+ */
+static int lov_io_submit_sorted(const struct lu_env *env, struct lov_io *lio,
+				enum cl_req_type crt, struct cl_2queue *queue,
+				struct lov_submit_job *jobs)
+{
+	struct cl_page_list	*qin = &queue->c2_qin;
+	struct lov_submit_sync	 sync;
+	struct cfs_wi_sched	*sched;
+	struct cl_page		*page;
+	int			 nr = lio->lis_stripe_count;
+	int			 njobs = 0;
+	int			 rc = 0;
+	int			 i;
+	ENTRY;
+
+	for (i = 0; i < nr; i++)
+		cl_2queue_init(&jobs[i].lsj_queue);
+
+	while (qin->pl_nr > 0) {
+		page = cl_page_list_first(qin);
+		i = lov_page_stripe(page);
+		if (jobs[i].lsj_queue.c2_qin.pl_nr == 0)
+			njobs++;
+		cl_page_list_move(&jobs[i].lsj_queue.c2_qin, qin, page);
+	}
+
+	for (i = 0; i < nr && rc == 0; i++) {
+		struct lov_io_sub *sub;
+
+		if (jobs[i].lsj_queue.c2_qin.pl_nr == 0)
+			continue;
+
+		sub = lov_sub_get(env, lio, i);
+		if (IS_ERR(sub))
+			rc = PTR_ERR(sub);
+		else
+			jobs[i].lsj_sub = sub;
+	}
+
+	if (rc == 0 && njobs >= lov_submit_parallel) {
+		sched = lov_submit_scheds[cfs_cpt_current(cfs_cpt_table, 0)];
+		atomic_set(&sync.lss_count, njobs);
+		init_completion(&sync.lss_done);
+		for (i = 0; i < nr; i++) {
+			struct lov_submit_job *job = &jobs[i];
+
+			if (job->lsj_sub == NULL)
+				continue;
+
+			job->lsj_sched = sched;
+			job->lsj_sync = &sync;
+			job->lsj_crt = crt;
+			job->lsj_owner = current;
+			cfs_wi_init(&job->lsj_wi, job, lov_submit_job_handler);
+			cfs_wi_schedule(sched, &job->lsj_wi);
+		}
+		wait_for_completion(&sync.lss_done);
+	} else if (rc == 0) {
+		for (i = 0; i < nr; i++) {
+			struct lov_submit_job *job = &jobs[i];
+
+			if (job->lsj_sub == NULL)
+				continue;
+
+			job->lsj_rc = cl_io_submit_rw(job->lsj_sub->sub_env,
+						      job->lsj_sub->sub_io,
+						      crt, &job->lsj_queue);
+		}
+	}
+
+	for (i = 0; i < nr; i++) {
+		struct lov_submit_job *job = &jobs[i];
+
+		if (job->lsj_sub != NULL) {
+			lov_sub_put(job->lsj_sub);
+			if (rc == 0)
+				rc = job->lsj_rc;
+		}
+		cl_page_list_splice(&job->lsj_queue.c2_qin, qin);
+		cl_page_list_splice(&job->lsj_queue.c2_qout, &queue->c2_qout);
+		cl_2queue_fini(env, &job->lsj_queue);
+	}
+	OBD_FREE_LARGE(jobs, nr * sizeof(jobs[0]));
+
+	RETURN(rc);
+}
+
 /**
  * lov implementation of cl_operations::cio_submit() method. It takes a list
  * of pages in \a queue, splits it into per-stripe sub-lists, invokes
@@ -618,6 +814,18 @@ static int lov_io_submit(const struct lu_env *env,
 
         LASSERT(lio->lis_subs != NULL);
 
+	if (lov_submit_parallel > 0 &&
+	    lio->lis_stripe_count >= lov_submit_parallel &&
+	    qin->pl_nr > lio->lis_stripe_count) {
+		struct lov_submit_job *jobs;
+
+		/* under memory pressure fall back to the serial loop below */
+		OBD_ALLOC_LARGE(jobs, lio->lis_stripe_count * sizeof(jobs[0]));
+		if (jobs != NULL)
+			RETURN(lov_io_submit_sorted(env, lio, crt, queue,
+						    jobs));
+	}
+
 	cl_page_list_init(plist);
 	while (qin->pl_nr > 0) {
 		struct cl_2queue  *cl2q = &lov_env_info(env)->lti_cl2q;
@@ -2189,6 +2189,13 @@ static int __init lov_init(void)
                 return -ENOMEM;
         }
 
+	rc = lov_io_submit_init();
+	if (rc != 0) {
+		kmem_cache_destroy(lov_oinfo_slab);
+		lu_kmem_fini(lov_caches);
+		return rc;
+	}
+
 	type = class_search_type(LUSTRE_LOD_NAME);
 	if (type != NULL && type->typ_procsym != NULL)
 		enable_proc = false;
@@ -2197,6 +2204,7 @@ static int __init lov_init(void)
 				 LUSTRE_LOV_NAME, &lov_device_type);
 
         if (rc) {
+		lov_io_submit_fini();
 		kmem_cache_destroy(lov_oinfo_slab);
                 lu_kmem_fini(lov_caches);
         }
@@ -2207,6 +2215,7 @@ static int __init lov_init(void)
 static void /*__exit*/ lov_exit(void)
 {
 	class_unregister_type(LUSTRE_LOV_NAME);
+	lov_io_submit_fini();
 	kmem_cache_destroy(lov_oinfo_slab);
 	lu_kmem_fini(lov_caches);
 }
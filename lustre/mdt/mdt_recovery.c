@@ -140,19 +140,13 @@ static void mdt_steal_ack_locks(struct ptlrpc_request *req)
 {
 	struct ptlrpc_service_part *svcpt;
 	struct obd_export	   *exp = req->rq_export;
-	struct list_head	   *tmp;
 	struct ptlrpc_reply_state  *oldrep;
 	int			    i;
 
 	/* CAVEAT EMPTOR: spinlock order */
 	spin_lock(&exp->exp_lock);
-	list_for_each(tmp, &exp->exp_outstanding_replies) {
-		oldrep = list_entry(tmp, struct ptlrpc_reply_state,
-				    rs_exp_list);
-
-                if (oldrep->rs_xid != req->rq_xid)
-                        continue;
-
+	oldrep = ptlrpc_rs_exp_find(exp, req->rq_xid);
+	if (oldrep != NULL) {
                 if (oldrep->rs_opc != lustre_msg_get_opc(req->rq_reqmsg))
                         CERROR ("Resent req xid "LPU64" has mismatched opc: "
                                 "new %d old %d\n", req->rq_xid,
@@ -162,7 +156,7 @@ static void mdt_steal_ack_locks(struct ptlrpc_request *req)
 		svcpt = oldrep->rs_svcpt;
 		spin_lock(&svcpt->scp_rep_lock);
 
-		list_del_init(&oldrep->rs_exp_list);
+		ptlrpc_rs_exp_del(oldrep);
 
 		CDEBUG(D_HA, "Stealing %d locks from rs %p x"LPD64".t"LPD64
 		       " o%d NID %s\n",
@@ -181,7 +175,6 @@ static void mdt_steal_ack_locks(struct ptlrpc_request *req)
 		spin_unlock(&oldrep->rs_lock);
 
 		spin_unlock(&svcpt->scp_rep_lock);
-		break;
 	}
 	spin_unlock(&exp->exp_lock);
 }
@@ -1344,4 +1344,5 @@ void cl_global_fini(void)
         lu_context_key_degister(&cl_key);
         lu_kmem_fini(cl_object_caches);
         cl_env_store_fini();
+	cl_page_kmem_fini();
 }
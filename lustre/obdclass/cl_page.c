@@ -51,6 +51,24 @@
 
 static void cl_page_delete0(const struct lu_env *env, struct cl_page *pg);
 
+/*
+ * A cl_page and the slices of all layers are allocated as one buffer of
+ * cl_object_header::coh_page_bufsize bytes. Only a few distinct sizes exist
+ * (one per layout type of every stack), so each gets its own slab cache,
+ * created on first use, instead of being rounded up to the next kmalloc
+ * size. This only makes each per-page descriptor cheaper; there is still one
+ * cl_page per VM page.
+ */
+#define CL_PAGE_KMEM_MAX	16
+
+static struct kmem_cache *cl_page_kmem_array[CL_PAGE_KMEM_MAX];
+static unsigned int cl_page_kmem_size_array[CL_PAGE_KMEM_MAX];
+/* kmem_cache_create() keeps the name pointer, so it must outlive the cache */
+static char cl_page_kmem_name[CL_PAGE_KMEM_MAX][32];
+static DEFINE_MUTEX(cl_page_kmem_mutex);
+/* set when kmem_cache_create() failed, all buffers then come from kmalloc */
+static bool cl_page_kmem_failed;
+
 #ifdef LIBCFS_DEBUG
 # define PASSERT(env, page, expr)                                       \
   do {                                                                    \
@@ -155,10 +173,95 @@ static void cl_page_free(const struct lu_env *env, struct cl_page *page)
 	lu_object_ref_del_at(&obj->co_lu, &page->cp_obj_ref, "cl_page", page);
 	cl_object_put(env, obj);
 	lu_ref_fini(&page->cp_reference);
-	OBD_FREE(page, pagesize);
+	if (page->cp_kmem_index >= 0)
+		OBD_SLAB_FREE(page, cl_page_kmem_array[page->cp_kmem_index],
+			      pagesize);
+	else
+		OBD_FREE(page, pagesize);
 	EXIT;
 }
 
+/**
+ * Returns the index of the slab cache for cl_page buffers of \a bufsize
+ * bytes, creating the cache if needed, or -1 if there is none.
+ */
+static int cl_page_kmem_index(unsigned int bufsize)
+{
+	int i;
+
+	for (i = 0; i < CL_PAGE_KMEM_MAX; i++) {
+		unsigned int size = ACCESS_ONCE(cl_page_kmem_size_array[i]);
+
+		if (size == bufsize) {
+			/* pairs with smp_wmb() below */
+			smp_rmb();
+			return i;
+		}
+		if (size == 0)
+			break;
+	}
+	if (i == CL_PAGE_KMEM_MAX || ACCESS_ONCE(cl_page_kmem_failed))
+		return -1;
+
+	mutex_lock(&cl_page_kmem_mutex);
+	for (; i < CL_PAGE_KMEM_MAX; i++) {
+		if (cl_page_kmem_size_array[i] == bufsize)
+			break;
+		if (cl_page_kmem_size_array[i] != 0)
+			continue;
+
+		snprintf(cl_page_kmem_name[i], sizeof(cl_page_kmem_name[i]),
+			 "cl_page_kmem-%u", bufsize);
+		cl_page_kmem_array[i] = kmem_cache_create(cl_page_kmem_name[i],
+							  bufsize, 0, 0, NULL);
+		if (cl_page_kmem_array[i] == NULL) {
+			/* do not retry under the mutex for every page */
+			cl_page_kmem_failed = true;
+			i = CL_PAGE_KMEM_MAX;
+			break;
+		}
+		smp_wmb();
+		cl_page_kmem_size_array[i] = bufsize;
+		break;
+	}
+	mutex_unlock(&cl_page_kmem_mutex);
+
+	return i < CL_PAGE_KMEM_MAX ? i : -1;
+}
+
+static struct cl_page *cl_page_buf_alloc(struct cl_object *o)
+{
+	struct cl_page	*page;
+	unsigned int	 bufsize = cl_object_header(o)->coh_page_bufsize;
+	int		 idx = cl_page_kmem_index(bufsize);
+
+	if (idx >= 0)
+		OBD_SLAB_ALLOC_GFP(page, cl_page_kmem_array[idx], bufsize,
+				   GFP_NOFS);
+	else
+		OBD_ALLOC_GFP(page, bufsize, GFP_NOFS);
+	if (page != NULL)
+		page->cp_kmem_index = idx;
+	return page;
+}
+
+/**
+ * Destroys slab caches of cl_page buffers. Called at module unload, when
+ * no cl_page is left.
+ */
+void cl_page_kmem_fini(void)
+{
+	int i;
+
+	for (i = 0; i < CL_PAGE_KMEM_MAX; i++) {
+		if (cl_page_kmem_array[i] == NULL)
+			break;
+		kmem_cache_destroy(cl_page_kmem_array[i]);
+		cl_page_kmem_array[i] = NULL;
+		cl_page_kmem_size_array[i] = 0;
+	}
+}
+
 /**
  * Helper function updating page state. This is the only place in the code
  * where cl_page::cp_state field is mutated.
@@ -178,8 +281,7 @@ struct cl_page *cl_page_alloc(const struct lu_env *env,
 	struct lu_object_header *head;
 
 	ENTRY;
-	OBD_ALLOC_GFP(page, cl_object_header(o)->coh_page_bufsize,
-			GFP_NOFS);
+	page = cl_page_buf_alloc(o);
 	if (page != NULL) {
 		int result = 0;
 		atomic_set(&page->cp_ref, 1);
@@ -855,6 +855,7 @@ struct obd_export *class_new_export(struct obd_device *obd,
         struct obd_export *export;
         cfs_hash_t *hash = NULL;
         int rc = 0;
+	int i;
         ENTRY;
 
         OBD_ALLOC_PTR(export);
@@ -875,6 +876,8 @@ struct obd_export *class_new_export(struct obd_device *obd,
 	atomic_set(&export->exp_replay_count, 0);
 	export->exp_obd = obd;
 	INIT_LIST_HEAD(&export->exp_outstanding_replies);
+	for (i = 0; i < EXP_REPLY_HASH_SIZE; i++)
+		INIT_HLIST_HEAD(&export->exp_reply_hash[i]);
 	spin_lock_init(&export->exp_uncommitted_replies_lock);
 	INIT_LIST_HEAD(&export->exp_uncommitted_replies);
 	INIT_LIST_HEAD(&export->exp_req_replay_queue);
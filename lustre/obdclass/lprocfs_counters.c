@@ -134,4 +134,59 @@ void lprocfs_counter_sub(struct lprocfs_stats *stats, int idx, long amount)
 	lprocfs_stats_unlock(stats, LPROCFS_GET_SMP_ID, &flags);
 }
 EXPORT_SYMBOL(lprocfs_counter_sub);
+
+/**
+ * Tally \a value into log2 histogram \a hist of index \a idx, on the
+ * current CPU.
+ *
+ * The per-CPU buckets are allocated on first use; if that fails the value
+ * is silently dropped, as for lprocfs_counter_add().
+ */
+void lprocfs_hist_tally_log2(struct lprocfs_hist_set *set, int idx, int hist,
+			     unsigned long value)
+{
+	__u32		**percpu;
+	__u32		 *cntr;
+	unsigned int	  val = 0;
+	int		  cpuid;
+
+	if (set == NULL)
+		return;
+
+	LASSERTF(0 <= idx && idx < set->lhs_num,
+		 "idx %d, lhs_num %hu\n", idx, set->lhs_num);
+	LASSERTF(0 <= hist && hist < set->lhs_width,
+		 "hist %d, lhs_width %hu\n", hist, set->lhs_width);
+
+	if (value > ~0U)
+		value = ~0U;
+	if (value > 1)
+		val = min(fls(value - 1), OBD_HIST_MAX - 1);
+
+	cpuid = get_cpu();
+	percpu = set->lhs_percpu[cpuid];
+	if (unlikely(percpu == NULL)) {
+		LIBCFS_ALLOC_ATOMIC(percpu, set->lhs_num * sizeof(percpu[0]));
+		if (percpu == NULL)
+			goto out;
+		/* publish only zeroed memory to lprocfs_hist_sum() */
+		smp_wmb();
+		set->lhs_percpu[cpuid] = percpu;
+	}
+
+	cntr = percpu[idx];
+	if (unlikely(cntr == NULL)) {
+		LIBCFS_ALLOC_ATOMIC(cntr, set->lhs_width * OBD_HIST_MAX *
+					  sizeof(cntr[0]));
+		if (cntr == NULL)
+			goto out;
+		smp_wmb();
+		percpu[idx] = cntr;
+	}
+
+	cntr[hist * OBD_HIST_MAX + val]++;
+out:
+	put_cpu();
+}
+EXPORT_SYMBOL(lprocfs_hist_tally_log2);
 #endif  /* LPROCFS */
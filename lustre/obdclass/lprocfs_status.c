@@ -886,6 +886,8 @@ static const char *obd_connect_names[] = {
 	"unknown",
 	"dir_stripe",
 	"unknown",
+	"lockahead",
+	"bl_batch",
 	NULL
 };
 
@@ -2057,6 +2059,123 @@ void lprocfs_oh_clear(struct obd_histogram *oh)
 }
 EXPORT_SYMBOL(lprocfs_oh_clear);
 
+static inline unsigned int lprocfs_hist_size(struct lprocfs_hist_set *set)
+{
+	return set->lhs_width * OBD_HIST_MAX * sizeof(__u32);
+}
+
+struct lprocfs_hist_set *lprocfs_hist_alloc(unsigned int num,
+					    unsigned int width)
+{
+	struct lprocfs_hist_set	*set;
+	unsigned int		 num_entry = num_possible_cpus();
+
+	if (num == 0 || width == 0)
+		return NULL;
+
+	LIBCFS_ALLOC(set, offsetof(typeof(*set), lhs_percpu[num_entry]));
+	if (set == NULL)
+		return NULL;
+
+	set->lhs_num = num;
+	set->lhs_width = width;
+
+	return set;
+}
+EXPORT_SYMBOL(lprocfs_hist_alloc);
+
+void lprocfs_hist_free(struct lprocfs_hist_set **seth)
+{
+	struct lprocfs_hist_set	*set = *seth;
+	unsigned int		 num_entry = num_possible_cpus();
+	unsigned int		 i;
+	unsigned int		 j;
+
+	if (set == NULL)
+		return;
+	*seth = NULL;
+
+	for (i = 0; i < num_entry; i++) {
+		if (set->lhs_percpu[i] == NULL)
+			continue;
+		for (j = 0; j < set->lhs_num; j++)
+			if (set->lhs_percpu[i][j] != NULL)
+				LIBCFS_FREE(set->lhs_percpu[i][j],
+					    lprocfs_hist_size(set));
+		LIBCFS_FREE(set->lhs_percpu[i],
+			    set->lhs_num * sizeof(set->lhs_percpu[i][0]));
+	}
+	LIBCFS_FREE(set, offsetof(typeof(*set), lhs_percpu[num_entry]));
+}
+EXPORT_SYMBOL(lprocfs_hist_free);
+
+/**
+ * Sum histogram \a hist of index \a idx over all CPUs.
+ *
+ * \param[in] set	histogram set
+ * \param[in] idx	index in the set
+ * \param[in] hist	histogram of the index, less than lhs_width
+ * \param[out] buckets	OBD_HIST_MAX summed buckets
+ *
+ * \retval		total number of values tallied
+ */
+unsigned long lprocfs_hist_sum(struct lprocfs_hist_set *set, int idx, int hist,
+			       unsigned long *buckets)
+{
+	unsigned long	 total = 0;
+	__u32		**percpu;
+	__u32		 *cntr;
+	int		  i;
+	int		  j;
+
+	memset(buckets, 0, OBD_HIST_MAX * sizeof(buckets[0]));
+	if (set == NULL)
+		return 0;
+
+	LASSERT(0 <= idx && idx < set->lhs_num);
+	LASSERT(0 <= hist && hist < set->lhs_width);
+
+	for (i = 0; i < num_possible_cpus(); i++) {
+		percpu = ACCESS_ONCE(set->lhs_percpu[i]);
+		if (percpu == NULL)
+			continue;
+		smp_rmb();
+		cntr = ACCESS_ONCE(percpu[idx]);
+		if (cntr == NULL)
+			continue;
+		smp_rmb();
+		cntr += hist * OBD_HIST_MAX;
+		for (j = 0; j < OBD_HIST_MAX; j++) {
+			buckets[j] += cntr[j];
+			total += cntr[j];
+		}
+	}
+
+	return total;
+}
+EXPORT_SYMBOL(lprocfs_hist_sum);
+
+void lprocfs_hist_clear(struct lprocfs_hist_set *set)
+{
+	__u32	**percpu;
+	int	  i;
+	int	  j;
+
+	if (set == NULL)
+		return;
+
+	for (i = 0; i < num_possible_cpus(); i++) {
+		percpu = ACCESS_ONCE(set->lhs_percpu[i]);
+		if (percpu == NULL)
+			continue;
+		smp_rmb();
+		for (j = 0; j < set->lhs_num; j++)
+			if (ACCESS_ONCE(percpu[j]) != NULL)
+				memset(percpu[j], 0, lprocfs_hist_size(set));
+	}
+}
+EXPORT_SYMBOL(lprocfs_hist_clear);
+
 int lprocfs_obd_rd_max_pages_per_rpc(char *page, char **start, off_t off,
 				     int count, int *eof, void *data)
 {
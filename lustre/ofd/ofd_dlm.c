@@ -96,6 +96,12 @@ static enum interval_iter ofd_intent_cb(struct interval_node *n, void *args)
 			*v = LDLM_LOCK_GET(lck);
 		}
 
+		/* Locks of a self-conflicting mode never overlap, so the
+		 * remaining nodes of this tree, visited in descending
+		 * order of start, can't have a higher start either. */
+		if (!lockmode_compat(lck->l_granted_mode, lck->l_granted_mode))
+			return INTERVAL_ITER_STOP;
+
 		/* the same policy group - every lock has the
 		 * same extent, so needn't do it any more */
 		break;
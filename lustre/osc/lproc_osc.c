@@ -243,6 +243,98 @@ static int osc_cur_dirty_bytes_seq_show(struct seq_file *m, void *v)
 }
 LPROC_SEQ_FOPS_RO(osc_cur_dirty_bytes);
 
+static int osc_congestion_seq_show(struct seq_file *m, void *v)
+{
+	struct obd_device *dev = m->private;
+	struct client_obd *cli = &dev->u.cli;
+	unsigned long limit;
+	__u32 lat_avg;
+	__u32 lat_min;
+	int enabled;
+
+	spin_lock(&cli->cl_loi_list_lock);
+	enabled = cli->cl_congest_throttle;
+	limit = osc_dirty_limit(cli);
+	lat_avg = cli->cl_w_lat_avg;
+	lat_min = cli->cl_w_lat_min;
+	spin_unlock(&cli->cl_loi_list_lock);
+
+	return seq_printf(m, "enabled:            %d\n"
+			  "congested:          %s\n"
+			  "write_latency_avg:  %u usec/MB\n"
+			  "write_latency_min:  %u usec/MB\n"
+			  "dirty_limit_pages:  %lu\n", enabled,
+			  limit < cli->cl_dirty_max_pages ? "yes" : "no",
+			  lat_avg, lat_min, limit);
+}
+
+static ssize_t osc_congestion_seq_write(struct file *file,
+					const char __user *buffer,
+					size_t count, loff_t *off)
+{
+	struct obd_device *dev = ((struct seq_file *)file->private_data)->private;
+	struct client_obd *cli = &dev->u.cli;
+	int rc, val;
+
+	rc = lprocfs_write_helper(buffer, count, &val);
+	if (rc)
+		return rc;
+
+	spin_lock(&cli->cl_loi_list_lock);
+	cli->cl_congest_throttle = !!val;
+	spin_unlock(&cli->cl_loi_list_lock);
+
+	return count;
+}
+LPROC_SEQ_FOPS(osc_congestion);
+
+static int osc_adaptive_rpc_seq_show(struct seq_file *m, void *v)
+{
+	struct obd_device *dev = m->private;
+	struct client_obd *cli = &dev->u.cli;
+	unsigned int pages;
+	unsigned int rif;
+	__u32 lat_min;
+	int enabled;
+
+	spin_lock(&cli->cl_loi_list_lock);
+	enabled = cli->cl_adaptive_rpc;
+	pages = osc_rpc_pages(cli);
+	rif = osc_rpcs_in_flight_max(cli);
+	lat_min = cli->cl_brw_lat_min;
+	spin_unlock(&cli->cl_loi_list_lock);
+
+	return seq_printf(m, "enabled:         %d\n"
+			  "pages_per_rpc:   %u\n"
+			  "rpcs_in_flight:  %u\n"
+			  "latency_min:     %u usec/MB\n",
+			  enabled, pages, rif, lat_min);
+}
+
+static ssize_t osc_adaptive_rpc_seq_write(struct file *file,
+					  const char __user *buffer,
+					  size_t count, loff_t *off)
+{
+	struct obd_device *dev = ((struct seq_file *)file->private_data)->private;
+	struct client_obd *cli = &dev->u.cli;
+	int rc, val;
+
+	rc = lprocfs_write_helper(buffer, count, &val);
+	if (rc)
+		return rc;
+
+	spin_lock(&cli->cl_loi_list_lock);
+	cli->cl_adaptive_rpc = !!val;
+	if (!val) {
+		cli->cl_rpc_pages_cur = 0;
+		cli->cl_rpcs_in_flight_cur = 0;
+	}
+	spin_unlock(&cli->cl_loi_list_lock);
+
+	return count;
+}
+LPROC_SEQ_FOPS(osc_adaptive_rpc);
+
 static int osc_cur_grant_bytes_seq_show(struct seq_file *m, void *v)
 {
 	struct obd_device *dev = m->private;
@@ -601,6 +693,8 @@ struct lprocfs_seq_vars lprocfs_osc_obd_vars[] = {
 	  .fops	=	&osc_obd_max_pages_per_rpc_fops	},
 	{ .name	=	"max_rpcs_in_flight",
 	  .fops	=	&osc_max_rpcs_in_flight_fops	},
+	{ .name	=	"adaptive_rpc",
+	  .fops	=	&osc_adaptive_rpc_fops		},
 	{ .name	=	"destroys_in_flight",
 	  .fops	=	&osc_destroys_in_flight_fops	},
 	{ .name	=	"max_dirty_mb",
@@ -609,6 +703,8 @@ struct lprocfs_seq_vars lprocfs_osc_obd_vars[] = {
 	  .fops	=	&osc_cached_mb_fops		},
 	{ .name	=	"cur_dirty_bytes",
 	  .fops	=	&osc_cur_dirty_bytes_fops	},
+	{ .name	=	"congestion",
+	  .fops	=	&osc_congestion_fops		},
 	{ .name	=	"cur_grant_bytes",
 	  .fops	=	&osc_cur_grant_bytes_fops	},
 	{ .name	=	"cur_lost_grant_bytes",
@@ -634,7 +634,7 @@ static struct osc_extent *osc_extent_find(const struct lu_env *env,
 	chunk      = index >> ppc_bits;
 
 	/* align end to rpc edge, rpc size may not be a power 2 integer. */
-	max_pages = cli->cl_max_pages_per_rpc;
+	max_pages = osc_rpc_pages(cli);
 	LASSERT((max_pages & ~chunk_mask) == 0);
 	max_end = index - (index % max_pages) + max_pages - 1;
 	max_end = min_t(pgoff_t, max_end, descr->cld_end);
@@ -1481,6 +1481,194 @@ static void osc_exit_cache(struct client_obd *cli, struct osc_async_page *oap)
 	spin_unlock(&cli->cl_loi_list_lock);
 }
 
+/*
+ * Congestion aware dirty throttling, enabled with the congestion tunable.
+ *
+ * The write latency per MB of an OSC, sampled over full RPCs only, is tracked
+ * as a moving average and a baseline, the lowest latency seen recently. When
+ * the average exceeds the baseline OSC_CONGEST_RATIO times, the OST is
+ * considered congested and the dirty cache of the OSC is shrunk in
+ * proportion, but never below max_rpcs_in_flight full RPCs, so that a single
+ * writer still fills the RPC pipeline. Writers to a slow OST then block
+ * early, instead of filling the dirty pages shared by all OSCs
+ * (obd_max_dirty_pages) and stalling writers to fast ones.
+ */
+#define OSC_CONGEST_RATIO	2
+
+/* weight of a new sample in the average, as a shift */
+#define OSC_LAT_AVG_SHIFT	3
+/* speed the baseline drifts up at, as a shift, so that it follows an OST
+ * whose unloaded latency changed */
+#define OSC_LAT_MIN_SHIFT	8
+
+/**
+ * Accounts a successful write RPC of \a nob bytes which completed in
+ * \a usec.
+ *
+ * caller must hold loi_list_lock
+ */
+void osc_update_write_latency(struct client_obd *cli, __u64 nob, long usec)
+{
+	__u64 lat;
+
+	/* smaller RPCs cost more per byte and would look congested */
+	if (nob == 0 || nob < ((__u64)osc_rpc_pages(cli) << PAGE_CACHE_SHIFT))
+		return;
+
+	lat = (__u64)max(usec, 1L) << 20;
+	do_div(lat, (__u32)nob);
+	lat = max_t(__u64, min_t(__u64, lat, ~0U), 1);
+
+	if (cli->cl_w_lat_min == 0) {
+		cli->cl_w_lat_min = lat;
+		cli->cl_w_lat_avg = lat;
+		return;
+	}
+
+	if (lat < cli->cl_w_lat_min)
+		cli->cl_w_lat_min = lat;
+	else
+		cli->cl_w_lat_min += (lat - cli->cl_w_lat_min) >>
+				     OSC_LAT_MIN_SHIFT;
+
+	cli->cl_w_lat_avg += ((long)lat - (long)cli->cl_w_lat_avg) >>
+			     OSC_LAT_AVG_SHIFT;
+}
+
+/**
+ * Returns the number of dirty pages the OSC may cache, cl_dirty_max_pages
+ * shrunk by how much the OST is congested.
+ *
+ * caller must hold loi_list_lock
+ */
+unsigned long osc_dirty_limit(struct client_obd *cli)
+{
+	unsigned long max = cli->cl_dirty_max_pages;
+	unsigned long floor;
+	__u64	      limit;
+
+	if (!cli->cl_congest_throttle || cli->cl_w_lat_min == 0 ||
+	    cli->cl_w_lat_avg <= OSC_CONGEST_RATIO * cli->cl_w_lat_min)
+		return max;
+
+	floor = min_t(unsigned long, max, (unsigned long)
+		      cli->cl_max_rpcs_in_flight * cli->cl_max_pages_per_rpc);
+	limit = (__u64)max * OSC_CONGEST_RATIO * cli->cl_w_lat_min;
+	do_div(limit, cli->cl_w_lat_avg);
+
+	return max_t(unsigned long, limit, floor);
+}
+
+/*
+ * Adaptive BRW RPC size and in-flight count.
+ *
+ * max_pages_per_rpc and max_rpcs_in_flight are the limits. Within them, each
+ * OSC sizes its window of RPCs in flight to about twice the bandwidth-delay
+ * product of the target, measured every OSC_ADAPT_PERIOD. This keeps enough
+ * in flight over a high latency route and keeps a local OST from being
+ * flooded. When the server holds an RPC for a second or more, or a full RPC
+ * takes OSC_BACKPRESSURE_RATIO times the baseline latency per MB, the window
+ * is halved, and once it is down to OSC_ADAPT_MIN_RIF, the RPC size is.
+ * Both recover additively, RPC size first. Disabled by default, see the
+ * adaptive_rpc tunable.
+ */
+#define OSC_ADAPT_PERIOD	cfs_time_seconds(1)
+#define OSC_ADAPT_MIN_RIF	2
+#define OSC_BACKPRESSURE_RATIO	4
+
+/**
+ * Accounts a successful BRW RPC of \a nob bytes which completed in \a usec,
+ * \a service_sec of which were spent in the server, and adapts the RPC size
+ * and in-flight count.
+ *
+ * caller must hold loi_list_lock
+ */
+void osc_rpc_adapt(struct client_obd *cli, __u64 nob, long usec,
+		   unsigned int service_sec)
+{
+	unsigned int	min_pages = 1 << (cli->cl_chunkbits - PAGE_CACHE_SHIFT);
+	unsigned int	pages = osc_rpc_pages(cli);
+	unsigned int	rif = osc_rpcs_in_flight_max(cli);
+	cfs_time_t	now = cfs_time_current();
+	cfs_duration_t	elapsed;
+	bool		slow = false;
+	__u64		bdp;
+	__u64		lat;
+
+	if (!cli->cl_adaptive_rpc) {
+		cli->cl_rpc_pages_cur = 0;
+		cli->cl_rpcs_in_flight_cur = 0;
+		return;
+	}
+
+	cli->cl_adapt_bytes += nob;
+
+	/* Only full RPCs of the current size are sampled, as latency per MB:
+	 * small RPCs cost more per byte, and comparing RPCs of different
+	 * sizes by latency alone makes every large one look slow. */
+	if (nob > 0 && nob >= ((__u64)pages << PAGE_CACHE_SHIFT)) {
+		lat = (__u64)max(usec, 1L) << 20;
+		do_div(lat, (__u32)nob);
+		lat = max_t(__u64, min_t(__u64, lat, ~0U), 1);
+
+		if (cli->cl_brw_lat_min == 0 || lat < cli->cl_brw_lat_min)
+			cli->cl_brw_lat_min = lat;
+		else
+			cli->cl_brw_lat_min += (lat - cli->cl_brw_lat_min) >>
+					       OSC_LAT_MIN_SHIFT;
+		slow = lat > OSC_BACKPRESSURE_RATIO * (__u64)cli->cl_brw_lat_min;
+	}
+
+	if (service_sec > 0)
+		slow = true;
+
+	/* A new period starts even under backpressure, otherwise the
+	 * backoff flag would never be cleared while the server stays busy and
+	 * the window could not shrink any further. */
+	elapsed = cfs_time_sub(now, cli->cl_adapt_start);
+	if (elapsed >= OSC_ADAPT_PERIOD) {
+		if (!slow && !cli->cl_adapt_backoff &&
+		    cli->cl_adapt_bytes > 0 && elapsed < 2 * OSC_ADAPT_PERIOD) {
+			/* bandwidth over the period times the unloaded
+			 * latency of an RPC, in RPCs: with the latency per MB,
+			 * this does not depend on the RPC size */
+			bdp = cli->cl_adapt_bytes * cli->cl_brw_lat_min;
+			do_div(bdp, jiffies_to_usecs(elapsed));
+			bdp >>= 20;
+
+			if (pages < cli->cl_max_pages_per_rpc)
+				pages = min(pages * 2,
+					    cli->cl_max_pages_per_rpc);
+			else if (2 * bdp + 1 > rif)
+				rif++;
+			else if (2 * bdp + 1 < rif && rif > OSC_ADAPT_MIN_RIF)
+				rif--;
+		}
+
+		cli->cl_adapt_start = now;
+		cli->cl_adapt_bytes = 0;
+		cli->cl_adapt_backoff = 0;
+	} else if (!slow) {
+		return;
+	}
+
+	if (slow) {
+		/* back off once per period, RPCs already in flight will see
+		 * the same backpressure */
+		if (cli->cl_adapt_backoff)
+			return;
+		cli->cl_adapt_backoff = 1;
+
+		if (rif > OSC_ADAPT_MIN_RIF)
+			rif = max_t(unsigned int, rif / 2, OSC_ADAPT_MIN_RIF);
+		else if (pages > min_pages)
+			pages = max((pages / 2) & ~(min_pages - 1), min_pages);
+	}
+
+	cli->cl_rpc_pages_cur = pages;
+	cli->cl_rpcs_in_flight_cur = rif;
+}
+
 /**
  * Non-blocking version of osc_enter_cache() that consumes grant only when it
  * is available.
@@ -1497,7 +1685,7 @@ static int osc_enter_cache_try(struct client_obd *cli,
 	if (rc < 0)
 		return 0;
 
-	if (cli->cl_dirty_pages < cli->cl_dirty_max_pages &&
+	if (cli->cl_dirty_pages < osc_dirty_limit(cli) &&
 	    1 + atomic_long_read(&obd_dirty_pages) <= obd_max_dirty_pages) {
 		osc_consume_write_grant(cli, &oap->oap_brw_page);
 		if (transient) {
@@ -1630,13 +1818,13 @@ void osc_wake_cache_waiters(struct client_obd *cli)
 
 		ocw->ocw_rc = -EDQUOT;
 		/* we can't dirty more */
-		if ((cli->cl_dirty_pages  >= cli->cl_dirty_max_pages) ||
+		if ((cli->cl_dirty_pages  >= osc_dirty_limit(cli)) ||
 		    (1 + atomic_long_read(&obd_dirty_pages) >
 		     obd_max_dirty_pages)) {
 			CDEBUG(D_CACHE, "no dirty room: dirty: %ld "
-			       "osc max %ld, sys max %ld\n",
+			       "osc max %ld limit %ld, sys max %ld\n",
 			       cli->cl_dirty_pages, cli->cl_dirty_max_pages,
-			       obd_max_dirty_pages);
+			       osc_dirty_limit(cli), obd_max_dirty_pages);
 			goto wakeup;
 		}
 
@@ -1657,7 +1845,7 @@ wakeup:
 static int osc_max_rpc_in_flight(struct client_obd *cli, struct osc_object *osc)
 {
 	int hprpc = !!list_empty(&osc->oo_hp_exts);
-	return rpcs_in_flight(cli) >= cli->cl_max_rpcs_in_flight + hprpc;
+	return rpcs_in_flight(cli) >= osc_rpcs_in_flight_max(cli) + hprpc;
 }
 
 /* This maintains the lists of pending pages to read/write for a given object
@@ -1698,8 +1886,7 @@ static int osc_makes_rpc(struct client_obd *cli, struct osc_object *osc,
 			CDEBUG(D_CACHE, "cache waiters forcing RPC\n");
 			RETURN(1);
 		}
-		if (atomic_read(&osc->oo_nr_writes) >=
-		    cli->cl_max_pages_per_rpc)
+		if (atomic_read(&osc->oo_nr_writes) >= osc_rpc_pages(cli))
 			RETURN(1);
 	} else {
 		if (atomic_read(&osc->oo_nr_reads) == 0)
@@ -1912,7 +2099,7 @@ static unsigned int get_write_extents(struct osc_object *obj,
 	struct client_obd *cli = osc_cli(obj);
 	struct osc_extent *ext;
 	unsigned int page_count = 0;
-	unsigned int max_pages = cli->cl_max_pages_per_rpc;
+	unsigned int max_pages = osc_rpc_pages(cli);
 
 	LASSERT(osc_object_is_locked(obj));
 	while (!list_empty(&obj->oo_hp_exts)) {
@@ -2052,7 +2239,7 @@ __must_hold(osc)
 	struct osc_extent *next;
 	struct list_head rpclist = LIST_HEAD_INIT(rpclist);
 	unsigned int page_count = 0;
-	unsigned int max_pages = cli->cl_max_pages_per_rpc;
+	unsigned int max_pages = osc_rpc_pages(cli);
 	int rc = 0;
 	ENTRY;
 
@@ -2614,7 +2801,7 @@ int osc_queue_sync_pages(const struct lu_env *env, struct osc_object *obj,
 	struct osc_extent     *ext;
 	struct osc_async_page *oap;
 	int     page_count = 0;
-	int     mppr       = cli->cl_max_pages_per_rpc;
+	int     mppr       = osc_rpc_pages(cli);
 	pgoff_t start      = CL_PAGE_EOF;
 	pgoff_t end        = 0;
 	ENTRY;
@@ -377,6 +377,10 @@ struct osc_page {
 	 * lru page list. See osc_lru_{del|use}() in osc_page.c for usage.
 	 */
 	struct list_head	ops_lru;
+	/**
+	 * CPT partition of client_obd::cl_lru_parts the page is queued on.
+	 */
+	int			ops_lru_cpt;
 	/**
 	 * Linkage into a per-osc_object list of pages in flight. For
 	 * debugging.
@@ -90,7 +90,39 @@ struct osc_cache_waiter {
 	int                     ocw_rc;
 };
 
+int osc_lru_init(struct client_obd *cli);
+void osc_lru_fini(struct client_obd *cli);
 void osc_wake_cache_waiters(struct client_obd *cli);
+void osc_update_write_latency(struct client_obd *cli, __u64 nob, long usec);
+unsigned long osc_dirty_limit(struct client_obd *cli);
+void osc_rpc_adapt(struct client_obd *cli, __u64 nob, long usec,
+		   unsigned int service_sec);
+
+/**
+ * Number of pages of a BRW RPC, as adapted by osc_rpc_adapt() within
+ * max_pages_per_rpc.
+ */
+static inline unsigned int osc_rpc_pages(struct client_obd *cli)
+{
+	unsigned int cur = cli->cl_rpc_pages_cur;
+
+	if (cur == 0 || cur > cli->cl_max_pages_per_rpc)
+		return cli->cl_max_pages_per_rpc;
+	return cur;
+}
+
+/**
+ * Number of BRW RPCs allowed in flight, as adapted by osc_rpc_adapt()
+ * within max_rpcs_in_flight.
+ */
+static inline unsigned int osc_rpcs_in_flight_max(struct client_obd *cli)
+{
+	unsigned int cur = cli->cl_rpcs_in_flight_cur;
+
+	if (cur == 0 || cur > cli->cl_max_rpcs_in_flight)
+		return cli->cl_max_rpcs_in_flight;
+	return cur;
+}
 int osc_shrink_grant_to_target(struct client_obd *cli, __u64 target_bytes);
 void osc_update_next_shrink(struct client_obd *cli);
 
@@ -173,6 +173,8 @@ static __u64 osc_enq2ldlm_flags(__u32 enqflags)
 		result |= LDLM_FL_AST_DISCARD_DATA;
 	if (enqflags & CEF_PEEK)
 		result |= LDLM_FL_TEST_LOCK;
+	if (enqflags & CEF_LOCK_NO_EXPAND)
+		result |= LDLM_FL_NO_EXPANSION;
 	return result;
 }
 
@@ -938,6 +940,11 @@ static int osc_lock_enqueue(const struct lu_env *env,
 	if (oscl->ols_state == OLS_GRANTED)
 		RETURN(0);
 
+	/* a server that does not know lock ahead would expand the lock */
+	if (oscl->ols_flags & LDLM_FL_NO_EXPANSION &&
+	    !exp_connect_lockahead(osc_export(osc)))
+		RETURN(-EOPNOTSUPP);
+
 	if (oscl->ols_flags & LDLM_FL_TEST_LOCK)
 		GOTO(enqueue_base, 0);
 
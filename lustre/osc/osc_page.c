@@ -535,6 +535,46 @@ static int osc_cache_too_much(struct client_obd *cli)
 	return 0;
 }
 
+/*
+ * The LRU of a client_obd is split into a list per CPT, each with its own
+ * lock, so that threads on different CPUs completing and freeing pages
+ * don't serialize on a single list lock. Pages are queued to the partition
+ * of the thread completing their transfer, a whole batch at once, and
+ * osc_lru_shrink() walks the partitions starting from its own. The LRU
+ * counters of the client_obd stay global.
+ */
+int osc_lru_init(struct client_obd *cli)
+{
+	struct cl_lru_part	*part;
+	int			 i;
+
+	cli->cl_lru_parts = cfs_percpt_alloc(cfs_cpt_table, sizeof(*part));
+	if (cli->cl_lru_parts == NULL)
+		return -ENOMEM;
+
+	cfs_percpt_for_each(part, i, cli->cl_lru_parts) {
+		spin_lock_init(&part->clp_lock);
+		INIT_LIST_HEAD(&part->clp_list);
+		part->clp_nr = 0;
+	}
+	return 0;
+}
+
+void osc_lru_fini(struct client_obd *cli)
+{
+	if (cli->cl_lru_parts == NULL)
+		return;
+
+	cfs_percpt_free(cli->cl_lru_parts);
+	cli->cl_lru_parts = NULL;
+}
+
+static inline struct cl_lru_part *osc_lru_part(struct client_obd *cli,
+					       struct osc_page *opg)
+{
+	return cli->cl_lru_parts[opg->ops_lru_cpt];
+}
+
 int lru_queue_work(const struct lu_env *env, void *data)
 {
 	struct client_obd *cli = data;
@@ -551,7 +591,9 @@ void osc_lru_add_batch(struct client_obd *cli, struct list_head *plist)
 {
 	struct list_head lru = LIST_HEAD_INIT(lru);
 	struct osc_async_page *oap;
+	struct cl_lru_part *part;
 	long npages = 0;
+	int cpt = cfs_cpt_current(cfs_cpt_table, 0);
 
 	list_for_each_entry(oap, plist, oap_pending_item) {
 		struct osc_page *opg = oap2osc_page(oap);
@@ -561,15 +603,18 @@ void osc_lru_add_batch(struct client_obd *cli, struct list_head *plist)
 
 		++npages;
 		LASSERT(list_empty(&opg->ops_lru));
+		opg->ops_lru_cpt = cpt;
 		list_add(&opg->ops_lru, &lru);
 	}
 
 	if (npages > 0) {
-		spin_lock(&cli->cl_lru_list_lock);
-		list_splice_tail(&lru, &cli->cl_lru_list);
+		part = cli->cl_lru_parts[cpt];
+		spin_lock(&part->clp_lock);
+		list_splice_tail(&lru, &part->clp_list);
+		part->clp_nr += npages;
+		spin_unlock(&part->clp_lock);
 		atomic_long_sub(npages, &cli->cl_lru_busy);
 		atomic_long_add(npages, &cli->cl_lru_in_list);
-		spin_unlock(&cli->cl_lru_list_lock);
 
 		/* XXX: May set force to be true for better performance */
 		if (osc_cache_too_much(cli))
@@ -577,10 +622,12 @@ void osc_lru_add_batch(struct client_obd *cli, struct list_head *plist)
 	}
 }
 
+/* caller must hold clp_lock of the partition of \a opg */
 static void __osc_lru_del(struct client_obd *cli, struct osc_page *opg)
 {
 	LASSERT(atomic_long_read(&cli->cl_lru_in_list) > 0);
 	list_del_init(&opg->ops_lru);
+	osc_lru_part(cli, opg)->clp_nr--;
 	atomic_long_dec(&cli->cl_lru_in_list);
 }
 
@@ -591,14 +638,16 @@ static void __osc_lru_del(struct client_obd *cli, struct osc_page *opg)
 static void osc_lru_del(struct client_obd *cli, struct osc_page *opg)
 {
 	if (opg->ops_in_lru) {
-		spin_lock(&cli->cl_lru_list_lock);
+		struct cl_lru_part *part = osc_lru_part(cli, opg);
+
+		spin_lock(&part->clp_lock);
 		if (!list_empty(&opg->ops_lru)) {
 			__osc_lru_del(cli, opg);
 		} else {
 			LASSERT(atomic_long_read(&cli->cl_lru_busy) > 0);
 			atomic_long_dec(&cli->cl_lru_busy);
 		}
-		spin_unlock(&cli->cl_lru_list_lock);
+		spin_unlock(&part->clp_lock);
 
 		atomic_long_inc(cli->cl_lru_left);
 		/* this is a great place to release more LRU pages if
@@ -620,9 +669,11 @@ static void osc_lru_use(struct client_obd *cli, struct osc_page *opg)
 	/* If page is being transfered for the first time,
 	 * ops_lru should be empty */
 	if (opg->ops_in_lru && !list_empty(&opg->ops_lru)) {
-		spin_lock(&cli->cl_lru_list_lock);
+		struct cl_lru_part *part = osc_lru_part(cli, opg);
+
+		spin_lock(&part->clp_lock);
 		__osc_lru_del(cli, opg);
-		spin_unlock(&cli->cl_lru_list_lock);
+		spin_unlock(&part->clp_lock);
 		atomic_long_inc(&cli->cl_lru_busy);
 	}
 }
@@ -675,11 +726,15 @@ long osc_lru_shrink(const struct lu_env *env, struct client_obd *cli,
 	struct cl_io *io;
 	struct cl_object *clobj = NULL;
 	struct cl_page **pvec;
+	struct cl_lru_part *part;
 	struct osc_page *opg;
 	long count = 0;
-	int maxscan = 0;
+	long maxscan = 0;
+	int ncpts = cfs_percpt_number(cli->cl_lru_parts);
+	int cpt = cfs_cpt_current(cfs_cpt_table, 0);
 	int index = 0;
 	int rc = 0;
+	int i;
 	ENTRY;
 
 	LASSERT(atomic_long_read(&cli->cl_lru_in_list) >= 0);
@@ -701,86 +756,94 @@ long osc_lru_shrink(const struct lu_env *env, struct client_obd *cli,
 	pvec = (struct cl_page **)osc_env_info(env)->oti_pvec;
 	io = &osc_env_info(env)->oti_io;
 
-	spin_lock(&cli->cl_lru_list_lock);
-	maxscan = min(target << 1, atomic_long_read(&cli->cl_lru_in_list));
-	while (!list_empty(&cli->cl_lru_list)) {
-		struct cl_page *page;
-		bool will_free = false;
+	/* start with the partition of this CPT, then go round the others */
+	for (i = 0; i < ncpts && count < target && rc == 0;
+	     i++, cpt = (cpt + 1) % ncpts) {
+		part = cli->cl_lru_parts[cpt];
 
-		if (--maxscan < 0)
-			break;
+		spin_lock(&part->clp_lock);
+		maxscan = min((target - count) << 1, part->clp_nr);
+		while (!list_empty(&part->clp_list)) {
+			struct cl_page *page;
+			bool will_free = false;
 
-		opg = list_entry(cli->cl_lru_list.next, struct osc_page,
-				 ops_lru);
-		page = opg->ops_cl.cpl_page;
-		if (lru_page_busy(cli, page)) {
-			list_move_tail(&opg->ops_lru, &cli->cl_lru_list);
-			continue;
-		}
+			if (--maxscan < 0)
+				break;
 
-		LASSERT(page->cp_obj != NULL);
-		if (clobj != page->cp_obj) {
-			struct cl_object *tmp = page->cp_obj;
+			opg = list_entry(part->clp_list.next, struct osc_page,
+					 ops_lru);
+			page = opg->ops_cl.cpl_page;
+			if (lru_page_busy(cli, page)) {
+				list_move_tail(&opg->ops_lru, &part->clp_list);
+				continue;
+			}
 
-			cl_object_get(tmp);
-			spin_unlock(&cli->cl_lru_list_lock);
+			LASSERT(page->cp_obj != NULL);
+			if (clobj != page->cp_obj) {
+				struct cl_object *tmp = page->cp_obj;
 
-			if (clobj != NULL) {
-				discard_pagevec(env, io, pvec, index);
-				index = 0;
+				cl_object_get(tmp);
+				spin_unlock(&part->clp_lock);
 
-				cl_io_fini(env, io);
-				cl_object_put(env, clobj);
-				clobj = NULL;
-			}
+				if (clobj != NULL) {
+					discard_pagevec(env, io, pvec, index);
+					index = 0;
 
-			clobj = tmp;
-			io->ci_obj = clobj;
-			io->ci_ignore_layout = 1;
-			rc = cl_io_init(env, io, CIT_MISC, clobj);
+					cl_io_fini(env, io);
+					cl_object_put(env, clobj);
+					clobj = NULL;
+				}
 
-			spin_lock(&cli->cl_lru_list_lock);
+				clobj = tmp;
+				io->ci_obj = clobj;
+				io->ci_ignore_layout = 1;
+				rc = cl_io_init(env, io, CIT_MISC, clobj);
 
-			if (rc != 0)
-				break;
+				spin_lock(&part->clp_lock);
 
-			++maxscan;
-			continue;
-		}
+				if (rc != 0)
+					break;
 
-		if (cl_page_own_try(env, io, page) == 0) {
-			if (!lru_page_busy(cli, page)) {
-				/* remove it from lru list earlier to avoid
-				 * lock contention */
-				__osc_lru_del(cli, opg);
-				opg->ops_in_lru = 0; /* will be discarded */
-
-				cl_page_get(page);
-				will_free = true;
-			} else {
-				cl_page_disown(env, io, page);
+				++maxscan;
+				continue;
 			}
-		}
 
-		if (!will_free) {
-			list_move_tail(&opg->ops_lru, &cli->cl_lru_list);
-			continue;
-		}
+			if (cl_page_own_try(env, io, page) == 0) {
+				if (!lru_page_busy(cli, page)) {
+					/* remove it from lru list earlier to
+					 * avoid lock contention */
+					__osc_lru_del(cli, opg);
+					/* will be discarded */
+					opg->ops_in_lru = 0;
+
+					cl_page_get(page);
+					will_free = true;
+				} else {
+					cl_page_disown(env, io, page);
+				}
+			}
 
-		/* Don't discard and free the page with cl_lru_list held */
-		pvec[index++] = page;
-		if (unlikely(index == OTI_PVEC_SIZE)) {
-			spin_unlock(&cli->cl_lru_list_lock);
-			discard_pagevec(env, io, pvec, index);
-			index = 0;
+			if (!will_free) {
+				list_move_tail(&opg->ops_lru, &part->clp_list);
+				continue;
+			}
 
-			spin_lock(&cli->cl_lru_list_lock);
-		}
+			/* Don't discard and free the page with clp_lock
+			 * held */
+			pvec[index++] = page;
+			if (unlikely(index == OTI_PVEC_SIZE)) {
+				spin_unlock(&part->clp_lock);
+				discard_pagevec(env, io, pvec, index);
+				index = 0;
 
-		if (++count >= target)
-			break;
+				spin_lock(&part->clp_lock);
+			}
+
+			if (++count >= target)
+				break;
+		}
+		spin_unlock(&part->clp_lock);
 	}
-	spin_unlock(&cli->cl_lru_list_lock);
 
 	if (clobj != NULL) {
 		discard_pagevec(env, io, pvec, index);
@@ -1634,6 +1634,8 @@ static int brw_interpret(const struct lu_env *env,
 	struct osc_extent *ext;
 	struct osc_extent *tmp;
 	struct client_obd *cli = aa->aa_cli;
+	struct timeval now;
+	long rpc_usec = -1;
         ENTRY;
 
         rc = osc_brw_fini_request(req, rc);
@@ -1736,7 +1738,20 @@ static int brw_interpret(const struct lu_env *env,
 	osc_release_ppga(aa->aa_ppga, aa->aa_page_count);
 	ptlrpc_lprocfs_brw(req, req->rq_bulk->bd_nob_transferred);
 
+	if (rc == 0) {
+		do_gettimeofday(&now);
+		rpc_usec = cfs_timeval_sub(&now, &req->rq_sent_tv, NULL);
+	}
+
 	spin_lock(&cli->cl_loi_list_lock);
+	if (rpc_usec >= 0) {
+		if (lustre_msg_get_opc(req->rq_reqmsg) == OST_WRITE)
+			osc_update_write_latency(cli,
+					req->rq_bulk->bd_nob_transferred,
+					rpc_usec);
+		osc_rpc_adapt(cli, req->rq_bulk->bd_nob_transferred, rpc_usec,
+			      lustre_msg_get_service_time(req->rq_repmsg));
+	}
 	/* We need to decrement before osc_ap_completion->osc_wake_cache_waiters
 	 * is called so we know whether to go to sync BRWs or wait for more
 	 * RPCs to complete */
@@ -2937,10 +2952,14 @@ int osc_setup(struct obd_device *obd, struct lustre_cfg *lcfg)
 		GOTO(out_ptlrpcd_work, rc = PTR_ERR(handler));
 	cli->cl_lru_work = handler;
 
-	rc = osc_quota_setup(obd);
+	rc = osc_lru_init(cli);
 	if (rc)
 		GOTO(out_ptlrpcd_work, rc);
 
+	rc = osc_quota_setup(obd);
+	if (rc)
+		GOTO(out_lru, rc);
+
 	cli->cl_grant_shrink_interval = GRANT_SHRINK_INTERVAL;
 
 #ifdef LPROCFS
@@ -2987,6 +3006,8 @@ int osc_setup(struct obd_device *obd, struct lustre_cfg *lcfg)
 	ns_register_cancel(obd->obd_namespace, osc_cancel_weight);
 	RETURN(0);
 
+out_lru:
+	osc_lru_fini(cli);
 out_ptlrpcd_work:
 	if (cli->cl_writeback_work != NULL) {
 		ptlrpcd_destroy_work(cli->cl_writeback_work);
@@ -3069,6 +3090,7 @@ int osc_cleanup(struct obd_device *obd)
 
         /* free memory of osc quota cache */
         osc_quota_cleanup(obd);
+	osc_lru_fini(cli);
 
         rc = client_obd_cleanup(obd);
 
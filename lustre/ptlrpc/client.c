@@ -1043,6 +1043,8 @@ void ptlrpc_set_add_new_req(struct ptlrpcd_ctl *pc,
 		 *      no other better choice. It maybe fixed in future. */
 		for (i = 0; i < pc->pc_npartners; i++)
 			wake_up(&pc->pc_partners[i]->pc_set->set_waitq);
+	} else {
+		ptlrpcd_steal_wake(pc, count - 1, count);
 	}
 }
 EXPORT_SYMBOL(ptlrpc_set_add_new_req);
@@ -369,6 +369,12 @@ static const struct req_msg_field *ldlm_enqueue_lvb_server[] = {
         &RMF_DLM_LVB
 };
 
+/* handles of the locks the client did not find, see ldlm_handle_bl_batch() */
+static const struct req_msg_field *ldlm_bl_callback_batch_server[] = {
+	&RMF_PTLRPC_BODY,
+	&RMF_DLM_REQ
+};
+
 static const struct req_msg_field *ldlm_cp_callback_client[] = {
         &RMF_PTLRPC_BODY,
         &RMF_DLM_REQ,
@@ -772,6 +778,7 @@ static struct req_format *req_formats[] = {
         &RQF_LDLM_CALLBACK,
         &RQF_LDLM_CP_CALLBACK,
         &RQF_LDLM_BL_CALLBACK,
+	&RQF_LDLM_BL_CALLBACK_BATCH,
         &RQF_LDLM_GL_CALLBACK,
 	&RQF_LDLM_GL_DESC_CALLBACK,
         &RQF_LDLM_INTENT,
@@ -1444,6 +1451,11 @@ struct req_format RQF_LDLM_BL_CALLBACK =
         DEFINE_REQ_FMT0("LDLM_BL_CALLBACK", ldlm_enqueue_client, empty);
 EXPORT_SYMBOL(RQF_LDLM_BL_CALLBACK);
 
+struct req_format RQF_LDLM_BL_CALLBACK_BATCH =
+	DEFINE_REQ_FMT0("LDLM_BL_CALLBACK_BATCH", ldlm_enqueue_client,
+			ldlm_bl_callback_batch_server);
+EXPORT_SYMBOL(RQF_LDLM_BL_CALLBACK_BATCH);
+
 struct req_format RQF_LDLM_GL_CALLBACK =
         DEFINE_REQ_FMT0("LDLM_GL_CALLBACK", ldlm_enqueue_client,
                         ldlm_gl_callback_server);
@@ -1670,6 +1682,9 @@ EXPORT_SYMBOL(RQF_LFSCK_QUERY);
 /* Convenience macro */
 #define FMT_FIELD(fmt, i, j) (fmt)->rf_fields[(i)].d[(j)]
 
+/** largest reply of all RQFs, not counting variable-size fields */
+static __u32 req_layout_reply_size;
+
 /**
  * Initializes the capsule abstraction by computing and setting the \a rf_idx
  * field of RQFs and the \a rmf_offset field of RMFs.
@@ -1684,6 +1699,9 @@ int req_layout_init(void)
         for (i = 0; i < ARRAY_SIZE(req_formats); ++i) {
                 rf = req_formats[i];
                 rf->rf_idx = i;
+		req_layout_reply_size = max(req_layout_reply_size,
+			req_capsule_fmt_size(LUSTRE_MSG_MAGIC_V2, rf,
+					     RCL_SERVER));
                 for (j = 0; j < RCL_NR; ++j) {
                         LASSERT(rf->rf_fields[j].nr <= REQ_MAX_FIELD_NR);
                         for (k = 0; k < rf->rf_fields[j].nr; ++k) {
@@ -1710,6 +1728,17 @@ void req_layout_fini(void)
 }
 EXPORT_SYMBOL(req_layout_fini);
 
+/**
+ * Returns the size of the largest reply message of all RQFs, counting only
+ * the fixed-size fields, i.e. a buffer of that size holds the reply of any
+ * RPC that carries no variable-size data.
+ */
+__u32 req_layout_fixed_reply_size(void)
+{
+	return req_layout_reply_size;
+}
+EXPORT_SYMBOL(req_layout_fixed_reply_size);
+
 /**
  * Initializes the expected sizes of each RMF in a \a pill (\a rc_area) to -1.
  *
@@ -418,6 +418,43 @@ ptlrpc_lprocfs_threads_max_seq_write(struct file *file,
 }
 LPROC_SEQ_FOPS(ptlrpc_lprocfs_threads_max);
 
+/**
+ * Target average time requests may wait in the NRS heads, in microseconds.
+ * More threads are started when requests wait longer than this, and threads
+ * above threads_min exit after being idle; 0 disables both.
+ */
+static int
+ptlrpc_lprocfs_threads_wait_target_seq_show(struct seq_file *m, void *n)
+{
+	struct ptlrpc_service *svc = m->private;
+
+	return seq_printf(m, "%d\n", svc->srv_qwait_target);
+}
+
+static ssize_t
+ptlrpc_lprocfs_threads_wait_target_seq_write(struct file *file,
+					     const char __user *buffer,
+					     size_t count, loff_t *off)
+{
+	struct seq_file		*m = file->private_data;
+	struct ptlrpc_service	*svc = m->private;
+	int	val;
+	int	rc = lprocfs_write_helper(buffer, count, &val);
+
+	if (rc < 0)
+		return rc;
+
+	if (val < 0)
+		return -ERANGE;
+
+	spin_lock(&svc->srv_lock);
+	svc->srv_qwait_target = val;
+	spin_unlock(&svc->srv_lock);
+
+	return count;
+}
+LPROC_SEQ_FOPS(ptlrpc_lprocfs_threads_wait_target);
+
 /**
  * Translates \e ptlrpc_nrs_pol_state values to human-readable strings.
  *
@@ -1057,6 +1094,102 @@ ptlrpc_lprocfs_hp_ratio_seq_write(struct file *file, const char __user *buffer,
 }
 LPROC_SEQ_FOPS(ptlrpc_lprocfs_hp_ratio);
 
+static int ptlrpc_lprocfs_batch_max_seq_show(struct seq_file *m, void *v)
+{
+	struct ptlrpc_service *svc = m->private;
+	return seq_printf(m, "%d\n", svc->srv_batch_max);
+}
+
+static ssize_t
+ptlrpc_lprocfs_batch_max_seq_write(struct file *file,
+				   const char __user *buffer,
+				   size_t count, loff_t *off)
+{
+	struct seq_file		*m = file->private_data;
+	struct ptlrpc_service	*svc = m->private;
+	int	rc;
+	int	val;
+
+	rc = lprocfs_write_helper(buffer, count, &val);
+	if (rc < 0)
+		return rc;
+
+	/* 1 disables batching */
+	if (val < 1)
+		return -ERANGE;
+
+	spin_lock(&svc->srv_lock);
+	svc->srv_batch_max = val;
+	spin_unlock(&svc->srv_lock);
+
+	return count;
+}
+LPROC_SEQ_FOPS(ptlrpc_lprocfs_batch_max);
+
+static const char *ptlrpc_latency_hist_names[PTLRPC_LAT_LAST] = {
+	[PTLRPC_LAT_QUEUE_WAIT]	= "queue_wait_us",
+	[PTLRPC_LAT_SERVICE]	= "service_us",
+	[PTLRPC_LAT_REPLY_SEND]	= "reply_send_us",
+};
+
+/*
+ * Dump the per-opcode latency histograms as YAML, only for opcodes that have
+ * been handled; each bucket is keyed by its upper bound in usec.
+ */
+static int ptlrpc_lprocfs_latency_hist_seq_show(struct seq_file *m, void *v)
+{
+	struct ptlrpc_service	*svc = m->private;
+	unsigned long		 buckets[OBD_HIST_MAX];
+	unsigned long		 total;
+	bool			 first;
+	int			 i;
+	int			 j;
+	int			 k;
+
+	if (svc->srv_latency_hist == NULL)
+		return 0;
+
+	for (i = 0; i < LUSTRE_MAX_OPCODES; i++) {
+		if (lprocfs_hist_sum(svc->srv_latency_hist, i,
+				     PTLRPC_LAT_QUEUE_WAIT, buckets) == 0)
+			continue;
+
+		seq_printf(m, "%s:\n", ll_rpc_opcode_table[i].opname);
+		for (j = 0; j < PTLRPC_LAT_LAST; j++) {
+			total = lprocfs_hist_sum(svc->srv_latency_hist, i, j,
+						 buckets);
+			seq_printf(m, "  %s: { samples: %lu",
+				   ptlrpc_latency_hist_names[j], total);
+			first = true;
+			for (k = 0; k < OBD_HIST_MAX; k++) {
+				if (buckets[k] == 0)
+					continue;
+				seq_printf(m, "%s%lu: %lu",
+					   first ? ", buckets: { " : ", ",
+					   1UL << k, buckets[k]);
+				first = false;
+			}
+			seq_printf(m, "%s }\n", first ? "" : " }");
+		}
+	}
+
+	return 0;
+}
+
+static ssize_t
+ptlrpc_lprocfs_latency_hist_seq_write(struct file *file,
+				      const char __user *buffer,
+				      size_t count, loff_t *off)
+{
+	struct seq_file		*m = file->private_data;
+	struct ptlrpc_service	*svc = m->private;
+
+	lprocfs_hist_clear(svc->srv_latency_hist);
+
+	return count;
+}
+LPROC_SEQ_FOPS(ptlrpc_lprocfs_latency_hist);
+
 void ptlrpc_lprocfs_register_service(struct proc_dir_entry *entry,
                                      struct ptlrpc_service *svc)
 {
@@ -1064,6 +1197,12 @@ void ptlrpc_lprocfs_register_service(struct proc_dir_entry *entry,
 		{ .name	= "high_priority_ratio",
 		  .fops	= &ptlrpc_lprocfs_hp_ratio_fops,
 		  .data = svc },
+		{ .name	= "req_batch_max",
+		  .fops	= &ptlrpc_lprocfs_batch_max_fops,
+		  .data = svc },
+		{ .name	= "req_latency_hist",
+		  .fops	= &ptlrpc_lprocfs_latency_hist_fops,
+		  .data	= svc },
 		{ .name	= "req_buffer_history_len",
 		  .fops	= &ptlrpc_lprocfs_req_history_len_fops,
 		  .data	= svc },
@@ -1079,6 +1218,9 @@ void ptlrpc_lprocfs_register_service(struct proc_dir_entry *entry,
 		{ .name = "threads_started",
 		  .fops = &ptlrpc_lprocfs_threads_started_fops,
 		  .data = svc },
+		{ .name = "threads_wait_target",
+		  .fops = &ptlrpc_lprocfs_threads_wait_target_fops,
+		  .data = svc },
 		{ .name = "timeouts",
 		  .fops = &ptlrpc_lprocfs_timeouts_fops,
 		  .data = svc },
@@ -1103,6 +1245,12 @@ void ptlrpc_lprocfs_register_service(struct proc_dir_entry *entry,
 	if (svc->srv_procroot == NULL)
 		return;
 
+	svc->srv_latency_hist = lprocfs_hist_alloc(LUSTRE_MAX_OPCODES,
+						   PTLRPC_LAT_LAST);
+	if (svc->srv_latency_hist == NULL)
+		CWARN("%s: cannot allocate latency histograms\n",
+		      svc->srv_name);
+
 	lprocfs_seq_add_vars(svc->srv_procroot, lproc_vars, NULL);
 
 	rc = lprocfs_seq_create(svc->srv_procroot, "req_history",
@@ -1168,6 +1316,8 @@ void ptlrpc_lprocfs_unregister_service(struct ptlrpc_service *svc)
 
         if (svc->srv_stats)
                 lprocfs_free_stats(&svc->srv_stats);
+
+	lprocfs_hist_free(&svc->srv_latency_hist);
 }
 
 void ptlrpc_lprocfs_unregister_obd(struct obd_device *obd)
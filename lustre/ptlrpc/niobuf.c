@@ -533,8 +533,12 @@ int ptlrpc_send_reply(struct ptlrpc_request *req, int flags)
 {
         struct ptlrpc_reply_state *rs = req->rq_reply_state;
         struct ptlrpc_connection  *conn;
+	struct timeval		   send_start;
+	struct timeval		   send_end;
         int                        rc;
 
+	do_gettimeofday(&send_start);
+
         /* We must already have a reply buffer (only ptlrpc_error() may be
          * called without one). The reply generated by sptlrpc layer (e.g.
          * error notify, etc.) might have NULL rq->reqmsg; Otherwise we must
@@ -612,6 +616,21 @@ out:
         if (unlikely(rc != 0))
                 ptlrpc_req_drop_rs(req);
         ptlrpc_connection_put(conn);
+
+	/* early replies are sent while the request is still being handled */
+	if (rc == 0 && !(flags & PTLRPC_REPLY_EARLY) &&
+	    req->rq_reqmsg != NULL &&
+	    ptlrpc_req2svc(req)->srv_latency_hist != NULL) {
+		int opc = opcode_offset(lustre_msg_get_opc(req->rq_reqmsg));
+
+		if (opc >= 0 && opc < LUSTRE_MAX_OPCODES) {
+			do_gettimeofday(&send_end);
+			lprocfs_hist_tally_log2(
+				ptlrpc_req2svc(req)->srv_latency_hist, opc,
+				PTLRPC_LAT_REPLY_SEND,
+				cfs_timeval_sub(&send_end, &send_start, NULL));
+		}
+	}
         return rc;
 }
 EXPORT_SYMBOL(ptlrpc_send_reply);
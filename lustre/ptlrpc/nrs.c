@@ -946,6 +946,17 @@ static int nrs_svcpt_setup_locked0(struct ptlrpc_nrs *nrs,
 	nrs->nrs_throttling = 0;
 
 	rc = nrs_register_policies_locked(nrs);
+	if (rc < 0)
+		RETURN(rc);
+
+	/**
+	 * The FIFO enqueue ring is only an optimization, so the head works
+	 * without it if it cannot be allocated.
+	 */
+	if (queue == PTLRPC_NRS_QUEUE_REG && nrs_fifo_ring_init(nrs) < 0)
+		CWARN("%s: cannot allocate FIFO enqueue ring for CPT %d, "
+		      "using locked enqueue\n",
+		      svcpt->scp_service->srv_name, svcpt->scp_cpt);
 
 	RETURN(rc);
 }
@@ -1039,6 +1050,8 @@ again:
 
 	if (hp)
 		OBD_FREE_PTR(nrs);
+	else
+		nrs_fifo_ring_fini(nrs);
 
 	EXIT;
 }
@@ -1503,8 +1516,24 @@ void ptlrpc_nrs_req_stop_nolock(struct ptlrpc_request *req)
 void ptlrpc_nrs_req_add(struct ptlrpc_service_part *svcpt,
 			struct ptlrpc_request *req, bool hp)
 {
+	int	rc = -EAGAIN;
+
+	/**
+	 * Try the lock-free FIFO enqueue ring first; \a req must not be
+	 * touched after it has been pushed there, as a service thread may
+	 * already be handling it.
+	 */
+	if (!hp) {
+		rc = nrs_fifo_ring_push(&svcpt->scp_nrs_reg, &req->rq_nrq);
+		if (rc == 0)
+			return;
+	}
+
 	spin_lock(&svcpt->scp_req_lock);
 
+	if (rc == -ENOSPC)
+		svcpt->scp_nrs_reg.nrs_fifo_ring->fr_nfull++;
+
 	if (hp)
 		ptlrpc_nrs_hpreq_add_nolock(req);
 	else
@@ -1513,6 +1542,36 @@ void ptlrpc_nrs_req_add(struct ptlrpc_service_part *svcpt,
 	spin_unlock(&svcpt->scp_req_lock);
 }
 
+/**
+ * Moves all requests from the FIFO enqueue ring of NRS head \a nrs to the
+ * policies they have been initialized for.
+ *
+ * \param[in] nrs the regular NRS head of a service partition
+ *
+ * \pre spin_is_locked(&nrs->nrs_svcpt->scp_req_lock)
+ */
+static void nrs_fifo_ring_splice_nolock(struct ptlrpc_nrs *nrs)
+{
+	struct nrs_fifo_ring	  *ring = nrs->nrs_fifo_ring;
+	struct ptlrpc_nrs_request *nrq;
+	__u64			   count = 0;
+
+	if (nrs_fifo_ring_empty(ring))
+		return;
+
+	while ((nrq = nrs_fifo_ring_pop(ring)) != NULL) {
+		ptlrpc_nrs_req_add_nolock(container_of(nrq,
+						       struct ptlrpc_request,
+						       rq_nrq));
+		count++;
+	}
+
+	if (count > 0) {
+		ring->fr_nfast += count;
+		ring->fr_nbatch++;
+	}
+}
+
 static void nrs_request_removed(struct ptlrpc_nrs_policy *policy)
 {
 	LASSERT(policy->pol_nrs->nrs_req_queued > 0);
@@ -1566,6 +1625,9 @@ ptlrpc_nrs_req_get_nolock0(struct ptlrpc_service_part *svcpt, bool hp,
 	struct ptlrpc_nrs_policy  *policy;
 	struct ptlrpc_nrs_request *nrq;
 
+	if (!hp)
+		nrs_fifo_ring_splice_nolock(nrs);
+
 	/**
 	 * Always try to drain requests from all NRS polices even if they are
 	 * inactive, because the user can change policy status at runtime.
@@ -1623,7 +1685,8 @@ bool ptlrpc_nrs_req_pending_nolock(struct ptlrpc_service_part *svcpt, bool hp)
 {
 	struct ptlrpc_nrs *nrs = nrs_svcpt2nrs(svcpt, hp);
 
-	return nrs->nrs_req_queued > 0;
+	return nrs->nrs_req_queued > 0 ||
+	       (!hp && !nrs_fifo_ring_empty(nrs->nrs_fifo_ring));
 };
 
 /**
@@ -1664,6 +1727,9 @@ void ptlrpc_nrs_req_hp_move(struct ptlrpc_request *req)
 
 	spin_lock(&svcpt->scp_req_lock);
 
+	/* \a req may still be waiting in the FIFO enqueue ring */
+	nrs_fifo_ring_splice_nolock(&svcpt->scp_nrs_reg);
+
 	if (!ptlrpc_nrs_req_can_move(req))
 		goto out;
 
@@ -1790,6 +1856,10 @@ int ptlrpc_nrs_init(void)
 	rc = ptlrpc_nrs_policy_register(&nrs_conf_tbf);
 	if (rc != 0)
 		GOTO(fail, rc);
+
+	rc = ptlrpc_nrs_policy_register(&nrs_conf_drr);
+	if (rc != 0)
+		GOTO(fail, rc);
 #endif /* HAVE_SERVER_SUPPORT */
 
 	RETURN(rc);
@@ -0,0 +1,966 @@
+/*
+ * GPL HEADER START
+ *
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 only,
+ * as published by the Free Software Foundation.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License version 2 for more details.  A copy is
+ * included in the COPYING file that accompanied this code.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * GPL HEADER END
+ */
+/*
+ * Copyright (c) 2014, Intel Corporation.
+ */
+/*
+ * lustre/ptlrpc/nrs_drr.c
+ *
+ * Network Request Scheduler (NRS) DRR policy
+ *
+ * Deficit Round Robin scheduling over client NIDs or JobIDs, charging each
+ * request by its estimated service cost rather than as a single unit.
+ */
+#ifdef HAVE_SERVER_SUPPORT
+
+/**
+ * \addtogoup nrs
+ * @{
+ */
+#define DEBUG_SUBSYSTEM S_RPC
+#include <obd_support.h>
+#include <obd_class.h>
+#include <lustre_net.h>
+#include <lustre/lustre_idl.h>
+#include <lustre_req_layout.h>
+#include <lprocfs_status.h>
+#include "ptlrpc_internal.h"
+
+/**
+ * \name DRR policy
+ *
+ * Every request is charged a fixed per-RPC cost plus the number of bytes
+ * described by its niobuf_remote array, if it is a brw RPC. Clients with
+ * queued requests are served in round robin order; on each visit a client
+ * is credited nrs_drr_head::dh_quantum, and may dispatch requests for as
+ * long as their cost is covered by its accumulated deficit. A client doing
+ * 16MB writes therefore needs many rounds per RPC, while a client doing 4KB
+ * reads dispatches many RPCs per round, so that bandwidth, and not the
+ * number of RPCs, is shared fairly.
+ *
+ * @{
+ */
+
+#define NRS_POL_NAME_DRR	"drr"
+
+#define NRS_DRR_BITS		10
+#define NRS_DRR_BKT_BITS	6
+#define NRS_DRR_HASH_FLAGS	(CFS_HASH_SPIN_BKTLOCK | CFS_HASH_ASSERT_EMPTY)
+
+/** Default quantum in KiB, i.e. one full size brw RPC per round. */
+#define NRS_DRR_QUANTUM_DFLT	(PTLRPC_MAX_BRW_SIZE >> 10)
+/** Default fixed per-RPC cost in bytes, as expensive as one page of I/O. */
+#define NRS_DRR_RPC_COST_DFLT	PAGE_CACHE_SIZE
+/** Maximum fixed per-RPC cost in bytes. */
+#define NRS_DRR_RPC_COST_MAX	PTLRPC_MAX_BRW_SIZE
+
+static unsigned nrs_drr_hop_hash(cfs_hash_t *hs, const void *key,
+				 unsigned mask)
+{
+	return cfs_hash_djb2_hash(key, sizeof(struct nrs_drr_key), mask);
+}
+
+static void *nrs_drr_hop_key(struct hlist_node *hnode)
+{
+	struct nrs_drr_client *cli = hlist_entry(hnode,
+						     struct nrs_drr_client,
+						     dc_hnode);
+	return &cli->dc_key;
+}
+
+static int nrs_drr_hop_keycmp(const void *key, struct hlist_node *hnode)
+{
+	struct nrs_drr_client *cli = hlist_entry(hnode,
+						     struct nrs_drr_client,
+						     dc_hnode);
+
+	return memcmp(&cli->dc_key, key, sizeof(struct nrs_drr_key)) == 0;
+}
+
+static void *nrs_drr_hop_object(struct hlist_node *hnode)
+{
+	return hlist_entry(hnode, struct nrs_drr_client, dc_hnode);
+}
+
+static void nrs_drr_hop_get(cfs_hash_t *hs, struct hlist_node *hnode)
+{
+	struct nrs_drr_client *cli = hlist_entry(hnode,
+						     struct nrs_drr_client,
+						     dc_hnode);
+	cli->dc_ref++;
+}
+
+/**
+ * Removes an nrs_drr_client from the hash and frees its memory, if the client
+ * has no more queued or started requests; idle clients have no state worth
+ * keeping, as the deficit of a client is reset when its queue drains.
+ */
+static void nrs_drr_hop_put_free(cfs_hash_t *hs, struct hlist_node *hnode)
+{
+	struct nrs_drr_client *cli = hlist_entry(hnode,
+						     struct nrs_drr_client,
+						     dc_hnode);
+	cfs_hash_bd_t	       bd;
+
+	cfs_hash_bd_get_and_lock(hs, &cli->dc_key, &bd, 1);
+
+	if (--cli->dc_ref > 1) {
+		cfs_hash_bd_unlock(hs, &bd, 1);
+
+		return;
+	}
+	LASSERT(cli->dc_ref == 1);
+	LASSERT(list_empty(&cli->dc_list));
+	LASSERT(list_empty(&cli->dc_active));
+
+	cfs_hash_bd_del_locked(hs, &bd, hnode);
+	cfs_hash_bd_unlock(hs, &bd, 1);
+
+	OBD_FREE_PTR(cli);
+}
+
+static void nrs_drr_hop_put(cfs_hash_t *hs, struct hlist_node *hnode)
+{
+	struct nrs_drr_client *cli = hlist_entry(hnode,
+						     struct nrs_drr_client,
+						     dc_hnode);
+	cli->dc_ref--;
+}
+
+static cfs_hash_ops_t nrs_drr_hash_ops = {
+	.hs_hash	= nrs_drr_hop_hash,
+	.hs_key		= nrs_drr_hop_key,
+	.hs_keycmp	= nrs_drr_hop_keycmp,
+	.hs_object	= nrs_drr_hop_object,
+	.hs_get		= nrs_drr_hop_get,
+	.hs_put		= nrs_drr_hop_put_free,
+	.hs_put_locked	= nrs_drr_hop_put,
+};
+
+/**
+ * Estimates the service cost of request \a nrq, in bytes.
+ *
+ * The cost is the fixed per-RPC cost of the policy instance, plus for
+ * OST_READ and OST_WRITE RPCs, the length of all the niobuf_remote entries
+ * of the request. The request format of brw RPCs has already been set by the
+ * service's hpreq handler at this point; see nrs_orr_range_fill().
+ *
+ * \param[in] head the policy instance private data
+ * \param[in] nrq  the request
+ *
+ * \retval the cost of the request
+ */
+static __u64 nrs_drr_req_cost(struct nrs_drr_head *head,
+			      struct ptlrpc_nrs_request *nrq)
+{
+	struct ptlrpc_request *req = container_of(nrq, struct ptlrpc_request,
+						  rq_nrq);
+	struct obd_ioobj      *ioo;
+	struct niobuf_remote  *nb;
+	__u64		       cost = head->dh_rpc_cost;
+	__u32		       opc = lustre_msg_get_opc(req->rq_reqmsg);
+	int		       i;
+
+	if (opc != OST_READ && opc != OST_WRITE)
+		return cost;
+
+	if (req->rq_pill.rc_fmt == NULL ||
+	    !req_capsule_has_field(&req->rq_pill, &RMF_NIOBUF_REMOTE,
+				   RCL_CLIENT))
+		return cost;
+
+	ioo = req_capsule_client_get(&req->rq_pill, &RMF_OBD_IOOBJ);
+	nb = req_capsule_client_get(&req->rq_pill, &RMF_NIOBUF_REMOTE);
+	if (ioo == NULL || nb == NULL)
+		return cost;
+
+	for (i = 0; i < ioo->ioo_bufcnt; i++)
+		cost += nb[i].len;
+
+	return cost;
+}
+
+/**
+ * Called when a DRR policy instance is started.
+ *
+ * \param[in] policy the policy
+ * \param[in] arg    "nid" or "jobid", to select the scheduling key; NID is
+ *		     used when no argument is given
+ *
+ * \retval -ENOMEM OOM error
+ * \retval -EINVAL invalid argument
+ * \retval 0	   success
+ */
+static int nrs_drr_start(struct ptlrpc_nrs_policy *policy, char *arg)
+{
+	struct nrs_drr_head	*head;
+	bool			 jobid = false;
+	int			 rc = 0;
+	ENTRY;
+
+	if (arg != NULL) {
+		if (strlen(arg) > NRS_DRR_TYPE_MAX_LEN)
+			RETURN(-EINVAL);
+		if (strcmp(arg, NRS_DRR_TYPE_JOBID) == 0)
+			jobid = true;
+		else if (strcmp(arg, NRS_DRR_TYPE_NID) != 0)
+			RETURN(-ENOTSUPP);
+	}
+
+	OBD_CPT_ALLOC_PTR(head, nrs_pol2cptab(policy), nrs_pol2cptid(policy));
+	if (head == NULL)
+		RETURN(-ENOMEM);
+
+	head->dh_cli_hash = cfs_hash_create("nrs_drr_hash",
+					    NRS_DRR_BITS, NRS_DRR_BITS,
+					    NRS_DRR_BKT_BITS, 0,
+					    CFS_HASH_MIN_THETA,
+					    CFS_HASH_MAX_THETA,
+					    &nrs_drr_hash_ops,
+					    NRS_DRR_HASH_FLAGS);
+	if (head->dh_cli_hash == NULL)
+		GOTO(failed, rc = -ENOMEM);
+
+	INIT_LIST_HEAD(&head->dh_active);
+	head->dh_jobid = jobid;
+	/* XXX: Fields accessed unlocked */
+	head->dh_quantum = NRS_DRR_QUANTUM_DFLT;
+	head->dh_rpc_cost = NRS_DRR_RPC_COST_DFLT;
+
+	policy->pol_private = head;
+
+	RETURN(rc);
+
+failed:
+	OBD_FREE_PTR(head);
+
+	RETURN(rc);
+}
+
+/**
+ * Called when a DRR policy instance is stopped.
+ *
+ * Called when the policy has been instructed to transition to the
+ * ptlrpc_nrs_pol_state::NRS_POL_STATE_STOPPED state and has no more pending
+ * requests to serve.
+ *
+ * \param[in] policy the policy
+ */
+static void nrs_drr_stop(struct ptlrpc_nrs_policy *policy)
+{
+	struct nrs_drr_head *head = policy->pol_private;
+	ENTRY;
+
+	LASSERT(head != NULL);
+	LASSERT(head->dh_cli_hash != NULL);
+	LASSERT(list_empty(&head->dh_active));
+
+	cfs_hash_putref(head->dh_cli_hash);
+
+	OBD_FREE_PTR(head);
+}
+
+/**
+ * Performs a policy-specific ctl function on DRR policy instances; similar
+ * to ioctl.
+ *
+ * \param[in]	  policy the policy instance
+ * \param[in]	  opc	 the opcode
+ * \param[in,out] arg	 used for passing parameters and information
+ *
+ * \pre assert_spin_locked(&policy->pol_nrs->->nrs_lock)
+ * \post assert_spin_locked(&policy->pol_nrs->->nrs_lock)
+ *
+ * \retval 0   operation carried out successfully
+ * \retval -ve error
+ */
+static int nrs_drr_ctl(struct ptlrpc_nrs_policy *policy,
+		       enum ptlrpc_nrs_ctl opc, void *arg)
+{
+	struct nrs_drr_head *head = policy->pol_private;
+
+	assert_spin_locked(&policy->pol_nrs->nrs_lock);
+
+	switch ((enum nrs_ctl_drr)opc) {
+	default:
+		RETURN(-EINVAL);
+
+	case NRS_CTL_DRR_RD_QUANTUM:
+		*(__u16 *)arg = head->dh_quantum;
+		break;
+
+	case NRS_CTL_DRR_WR_QUANTUM:
+		head->dh_quantum = *(__u16 *)arg;
+		LASSERT(head->dh_quantum != 0);
+		break;
+
+	case NRS_CTL_DRR_RD_RPC_COST:
+		*(__u32 *)arg = head->dh_rpc_cost;
+		break;
+
+	case NRS_CTL_DRR_WR_RPC_COST:
+		head->dh_rpc_cost = *(__u32 *)arg;
+		break;
+	}
+
+	RETURN(0);
+}
+
+/**
+ * Obtains resources from DRR policy instances. The top-level resource lives
+ * inside \e nrs_drr_head and the second-level resource inside
+ * \e nrs_drr_client object instances.
+ *
+ * \param[in]  policy	  the policy for which resources are being taken for
+ *			  request \a nrq
+ * \param[in]  nrq	  the request for which resources are being taken
+ * \param[in]  parent	  parent resource, embedded in nrs_drr_head for the
+ *			  DRR policy
+ * \param[out] resp	  resources references are placed in this array
+ * \param[in]  moving_req signifies limited caller context; used to perform
+ *			  memory allocations in an atomic context in this
+ *			  policy
+ *
+ * \retval 0   we are returning a top-level, parent resource, one that is
+ *	       embedded in an nrs_drr_head object
+ * \retval 1   we are returning a bottom-level resource, one that is embedded
+ *	       in an nrs_drr_client object
+ *
+ * \see nrs_resource_get_safe()
+ */
+static int nrs_drr_res_get(struct ptlrpc_nrs_policy *policy,
+			   struct ptlrpc_nrs_request *nrq,
+			   const struct ptlrpc_nrs_resource *parent,
+			   struct ptlrpc_nrs_resource **resp, bool moving_req)
+{
+	struct nrs_drr_head	*head;
+	struct nrs_drr_client	*cli;
+	struct nrs_drr_client	*tmp;
+	struct ptlrpc_request	*req;
+	struct nrs_drr_key	 key;
+
+	if (parent == NULL) {
+		*resp = &((struct nrs_drr_head *)policy->pol_private)->dh_res;
+		return 0;
+	}
+
+	head = container_of(parent, struct nrs_drr_head, dh_res);
+	req = container_of(nrq, struct ptlrpc_request, rq_nrq);
+
+	memset(&key, 0, sizeof(key));
+	if (head->dh_jobid) {
+		char *jobid = lustre_msg_get_jobid(req->rq_reqmsg);
+
+		if (jobid != NULL)
+			strlcpy(key.dk_jobid, jobid, sizeof(key.dk_jobid));
+	} else {
+		key.dk_nid = req->rq_peer.nid;
+	}
+
+	/* Cost is fixed for the lifetime of the request */
+	nrq->nr_u.drr.dr_cost = nrs_drr_req_cost(head, nrq);
+
+	cli = cfs_hash_lookup(head->dh_cli_hash, &key);
+	if (cli != NULL)
+		goto out;
+
+	OBD_CPT_ALLOC_GFP(cli, nrs_pol2cptab(policy), nrs_pol2cptid(policy),
+			  sizeof(*cli), moving_req ? GFP_ATOMIC : GFP_NOFS);
+	if (cli == NULL)
+		return -ENOMEM;
+
+	cli->dc_key = key;
+	cli->dc_ref = 1;
+	INIT_LIST_HEAD(&cli->dc_list);
+	INIT_LIST_HEAD(&cli->dc_active);
+
+	tmp = cfs_hash_findadd_unique(head->dh_cli_hash, &cli->dc_key,
+				      &cli->dc_hnode);
+	if (tmp != cli) {
+		OBD_FREE_PTR(cli);
+		cli = tmp;
+	}
+out:
+	*resp = &cli->dc_res;
+
+	return 1;
+}
+
+/**
+ * Called when releasing references to the resource hierachy obtained for a
+ * request for scheduling using the DRR policy.
+ *
+ * \param[in] policy   the policy the resource belongs to
+ * \param[in] res      the resource to be released
+ */
+static void nrs_drr_res_put(struct ptlrpc_nrs_policy *policy,
+			    const struct ptlrpc_nrs_resource *res)
+{
+	struct nrs_drr_head	*head;
+	struct nrs_drr_client	*cli;
+
+	/**
+	 * Do nothing for freeing parent, nrs_drr_head resources
+	 */
+	if (res->res_parent == NULL)
+		return;
+
+	cli = container_of(res, struct nrs_drr_client, dc_res);
+	head = container_of(res->res_parent, struct nrs_drr_head, dh_res);
+
+	cfs_hash_put(head->dh_cli_hash, &cli->dc_hnode);
+}
+
+/**
+ * Takes \a cli off the round robin list once it has no more queued requests;
+ * as in classic DRR, an idle client does not keep its unused deficit.
+ */
+static void nrs_drr_cli_deactivate(struct nrs_drr_client *cli)
+{
+	if (list_empty(&cli->dc_list)) {
+		list_del_init(&cli->dc_active);
+		cli->dc_deficit = 0;
+	}
+}
+
+/**
+ * Finds the client whose oldest request the round robin dispatches next,
+ * without changing any state.
+ *
+ * The round robin visits the clients of nrs_drr_head::dh_active in order; a
+ * client whose deficit does not cover the cost of its oldest request is
+ * credited with a quantum and moved to the tail of the list. A client at
+ * position \a pos that needs \a r more quanta is thus served on visit
+ * r * nr_active + pos, so the next client served is the first one, in list
+ * order, of those needing the fewest quanta.
+ *
+ * \param[in]  head   the DRR policy instance
+ * \param[out] rounds the number of quanta the returned client is short of
+ *
+ * \retval the client to be served next
+ */
+static struct nrs_drr_client *nrs_drr_select(struct nrs_drr_head *head,
+					     __u64 *rounds)
+{
+	struct nrs_drr_client	  *cli;
+	struct nrs_drr_client	  *best = NULL;
+	struct ptlrpc_nrs_request *nrq;
+	__u32			   quantum = (__u32)head->dh_quantum << 10;
+	__u64			   r;
+
+	*rounds = 0;
+	list_for_each_entry(cli, &head->dh_active, dc_active) {
+		LASSERT(!list_empty(&cli->dc_list));
+		nrq = list_entry(cli->dc_list.next, struct ptlrpc_nrs_request,
+				 nr_u.drr.dr_list);
+		r = 0;
+		if (nrq->nr_u.drr.dr_cost > cli->dc_deficit) {
+			r = nrq->nr_u.drr.dr_cost - cli->dc_deficit +
+			    quantum - 1;
+			do_div(r, quantum);
+		}
+
+		if (best == NULL || r < *rounds) {
+			best = cli;
+			*rounds = r;
+			if (r == 0)
+				break;
+		}
+	}
+
+	return best;
+}
+
+/**
+ * Called when getting a request from the DRR policy for handling, or just
+ * peeking; removes the request from the policy when it is to be handled.
+ *
+ * The client at the head of nrs_drr_head::dh_active is served for as long as
+ * its deficit covers the cost of its oldest request; otherwise it is credited
+ * with another quantum and moved to the tail of the list, and the next client
+ * gets its turn. Rather than going around the list once per quantum, the
+ * client served next is found by nrs_drr_select(), and every client is
+ * credited with all the quanta the round robin would have given it, in a
+ * single pass.
+ *
+ * \param[in] policy the policy being polled
+ * \param[in] peek   when set, signifies that we just want to examine the
+ *		     request, and not handle it, so the request is not removed
+ *		     from the policy.
+ * \param[in] force  force the policy to return a request; unused in this policy
+ *
+ * \retval the request to be handled
+ * \retval NULL no request available
+ *
+ * \see ptlrpc_nrs_req_get_nolock()
+ * \see nrs_request_get()
+ */
+static
+struct ptlrpc_nrs_request *nrs_drr_req_get(struct ptlrpc_nrs_policy *policy,
+					   bool peek, bool force)
+{
+	struct nrs_drr_head	  *head = policy->pol_private;
+	struct nrs_drr_client	  *cli;
+	struct nrs_drr_client	  *tmp;
+	struct ptlrpc_nrs_request *nrq;
+	struct ptlrpc_request	  *req;
+	__u64			   rounds;
+	__u64			   quantum = (__u64)head->dh_quantum << 10;
+	bool			   before = true;
+
+	if (unlikely(list_empty(&head->dh_active)))
+		return NULL;
+
+	cli = nrs_drr_select(head, &rounds);
+	nrq = list_entry(cli->dc_list.next, struct ptlrpc_nrs_request,
+			 nr_u.drr.dr_list);
+	if (peek)
+		return nrq;
+
+	if (rounds > 0 || head->dh_active.next != &cli->dc_active) {
+		/* clients ahead of \a cli were visited once more than it */
+		list_for_each_entry(tmp, &head->dh_active, dc_active) {
+			if (tmp == cli)
+				before = false;
+			tmp->dc_deficit += (rounds + before) * quantum;
+		}
+		/* continue the round robin from \a cli */
+		list_del(&head->dh_active);
+		list_add_tail(&head->dh_active, &cli->dc_active);
+	}
+
+	LASSERT(nrq->nr_u.drr.dr_cost <= cli->dc_deficit);
+	cli->dc_deficit -= nrq->nr_u.drr.dr_cost;
+	list_del_init(&nrq->nr_u.drr.dr_list);
+	nrs_drr_cli_deactivate(cli);
+
+	req = container_of(nrq, struct ptlrpc_request, rq_nrq);
+	CDEBUG(D_RPCTRACE,
+	       "NRS: starting to handle %s request from %s, cost "LPU64
+	       ", seq: "LPU64"\n", NRS_POL_NAME_DRR,
+	       libcfs_id2str(req->rq_peer), nrq->nr_u.drr.dr_cost,
+	       nrq->nr_u.drr.dr_sequence);
+
+	return nrq;
+}
+
+/**
+ * Adds request \a nrq to a DRR \a policy instance's set of queued requests;
+ * a client that had no queued requests joins the tail of the round robin
+ * list with no deficit.
+ *
+ * \param[in] policy the policy
+ * \param[in] nrq    the request to add
+ *
+ * \retval 0 request successfully added
+ */
+static int nrs_drr_req_add(struct ptlrpc_nrs_policy *policy,
+			   struct ptlrpc_nrs_request *nrq)
+{
+	struct nrs_drr_head	*head;
+	struct nrs_drr_client	*cli;
+
+	cli = container_of(nrs_request_resource(nrq),
+			   struct nrs_drr_client, dc_res);
+	head = container_of(nrs_request_resource(nrq)->res_parent,
+			    struct nrs_drr_head, dh_res);
+
+	if (list_empty(&cli->dc_list)) {
+		LASSERT(list_empty(&cli->dc_active));
+		list_add_tail(&cli->dc_active, &head->dh_active);
+	}
+
+	nrq->nr_u.drr.dr_sequence = head->dh_sequence++;
+	list_add_tail(&nrq->nr_u.drr.dr_list, &cli->dc_list);
+
+	return 0;
+}
+
+/**
+ * Removes request \a nrq from a DRR \a policy instance's set of queued
+ * requests.
+ *
+ * \param[in] policy the policy
+ * \param[in] nrq    the request to remove
+ */
+static void nrs_drr_req_del(struct ptlrpc_nrs_policy *policy,
+			    struct ptlrpc_nrs_request *nrq)
+{
+	struct nrs_drr_client *cli;
+
+	cli = container_of(nrs_request_resource(nrq),
+			   struct nrs_drr_client, dc_res);
+
+	LASSERT(!list_empty(&nrq->nr_u.drr.dr_list));
+	list_del_init(&nrq->nr_u.drr.dr_list);
+	nrs_drr_cli_deactivate(cli);
+}
+
+/**
+ * Prints a debug statement right before the request \a nrq stops being
+ * handled.
+ *
+ * \param[in] policy The policy handling the request
+ * \param[in] nrq    The request being handled
+ *
+ * \see ptlrpc_server_finish_request()
+ * \see ptlrpc_nrs_req_stop_nolock()
+ */
+static void nrs_drr_req_stop(struct ptlrpc_nrs_policy *policy,
+			     struct ptlrpc_nrs_request *nrq)
+{
+	struct ptlrpc_request *req = container_of(nrq, struct ptlrpc_request,
+						  rq_nrq);
+
+	CDEBUG(D_RPCTRACE,
+	       "NRS: finished handling %s request from %s, cost "LPU64"\n",
+	       NRS_POL_NAME_DRR, libcfs_id2str(req->rq_peer),
+	       nrq->nr_u.drr.dr_cost);
+}
+
+#ifdef LPROCFS
+
+/**
+ * lprocfs interface
+ */
+
+/**
+ * Retrieves the DRR quantum, in KiB, of policy instances on both the regular
+ * and high-priority NRS head of a service, in the same format as
+ * nrs_crrn_quantum.
+ *
+ * For example:
+ *
+ *	reg_quantum:1024
+ *	hp_quantum:1024
+ */
+static int
+ptlrpc_lprocfs_nrs_drr_quantum_seq_show(struct seq_file *m, void *data)
+{
+	struct ptlrpc_service	*svc = m->private;
+	__u16			quantum;
+	int			rc;
+
+	rc = ptlrpc_nrs_policy_control(svc, PTLRPC_NRS_QUEUE_REG,
+				       NRS_POL_NAME_DRR,
+				       NRS_CTL_DRR_RD_QUANTUM,
+				       true, &quantum);
+	if (rc == 0) {
+		seq_printf(m, NRS_LPROCFS_QUANTUM_NAME_REG
+			   "%-5d\n", quantum);
+		/**
+		 * Ignore -ENODEV as the regular NRS head's policy may be in the
+		 * ptlrpc_nrs_pol_state::NRS_POL_STATE_STOPPED state.
+		 */
+	} else if (rc != -ENODEV) {
+		return rc;
+	}
+
+	if (!nrs_svc_has_hp(svc))
+		goto no_hp;
+
+	rc = ptlrpc_nrs_policy_control(svc, PTLRPC_NRS_QUEUE_HP,
+				       NRS_POL_NAME_DRR,
+				       NRS_CTL_DRR_RD_QUANTUM,
+				       true, &quantum);
+	if (rc == 0) {
+		seq_printf(m, NRS_LPROCFS_QUANTUM_NAME_HP"%-5d\n", quantum);
+		/**
+		 * Ignore -ENODEV as the high priority NRS head's policy may be
+		 * in the ptlrpc_nrs_pol_state::NRS_POL_STATE_STOPPED state.
+		 */
+	} else if (rc != -ENODEV) {
+		return rc;
+	}
+
+no_hp:
+	return rc;
+}
+
+/**
+ * Sets the DRR quantum, in KiB, of policy instances of a service; accepts the
+ * same reg_quantum:/hp_quantum: syntax as nrs_crrn_quantum.
+ *
+ * For example:
+ *
+ * lctl set_param ost.OSS.ost_io.nrs_drr_quantum=4096, to credit each client
+ * with 4MB worth of requests per round on both NRS heads of ost_io.
+ */
+static ssize_t
+ptlrpc_lprocfs_nrs_drr_quantum_seq_write(struct file *file,
+					 const char *buffer, size_t count,
+					 loff_t *off)
+{
+	struct ptlrpc_service	    *svc = ((struct seq_file *)file->private_data)->private;
+	enum ptlrpc_nrs_queue_type   queue = 0;
+	char			     kernbuf[LPROCFS_NRS_WR_QUANTUM_MAX_CMD];
+	char			    *val;
+	long			     quantum_reg;
+	long			     quantum_hp;
+	/** lprocfs_find_named_value() modifies its argument, so keep a copy */
+	size_t			     count_copy;
+	int			     rc = 0;
+	int			     rc2 = 0;
+
+	if (count > (sizeof(kernbuf) - 1))
+		return -EINVAL;
+
+	if (copy_from_user(kernbuf, buffer, count))
+		return -EFAULT;
+
+	kernbuf[count] = '\0';
+
+	count_copy = count;
+
+	val = lprocfs_find_named_value(kernbuf, NRS_LPROCFS_QUANTUM_NAME_REG,
+				       &count_copy);
+	if (val != kernbuf) {
+		quantum_reg = simple_strtol(val, NULL, 10);
+
+		queue |= PTLRPC_NRS_QUEUE_REG;
+	}
+
+	count_copy = count;
+
+	val = lprocfs_find_named_value(kernbuf, NRS_LPROCFS_QUANTUM_NAME_HP,
+				       &count_copy);
+	if (val != kernbuf) {
+		if (!nrs_svc_has_hp(svc))
+			return -ENODEV;
+
+		quantum_hp = simple_strtol(val, NULL, 10);
+
+		queue |= PTLRPC_NRS_QUEUE_HP;
+	}
+
+	if (queue == 0) {
+		if (!isdigit(kernbuf[0]))
+			return -EINVAL;
+
+		quantum_reg = simple_strtol(kernbuf, NULL, 10);
+
+		queue = PTLRPC_NRS_QUEUE_REG;
+
+		if (nrs_svc_has_hp(svc)) {
+			queue |= PTLRPC_NRS_QUEUE_HP;
+			quantum_hp = quantum_reg;
+		}
+	}
+
+	if ((((queue & PTLRPC_NRS_QUEUE_REG) != 0) &&
+	    ((quantum_reg > LPROCFS_NRS_QUANTUM_MAX || quantum_reg <= 0))) ||
+	    (((queue & PTLRPC_NRS_QUEUE_HP) != 0) &&
+	    ((quantum_hp > LPROCFS_NRS_QUANTUM_MAX || quantum_hp <= 0))))
+		return -EINVAL;
+
+	if ((queue & PTLRPC_NRS_QUEUE_REG) != 0) {
+		rc = ptlrpc_nrs_policy_control(svc, PTLRPC_NRS_QUEUE_REG,
+					       NRS_POL_NAME_DRR,
+					       NRS_CTL_DRR_WR_QUANTUM, false,
+					       &quantum_reg);
+		if ((rc < 0 && rc != -ENODEV) ||
+		    (rc == -ENODEV && queue == PTLRPC_NRS_QUEUE_REG))
+			return rc;
+	}
+
+	if ((queue & PTLRPC_NRS_QUEUE_HP) != 0) {
+		rc2 = ptlrpc_nrs_policy_control(svc, PTLRPC_NRS_QUEUE_HP,
+						NRS_POL_NAME_DRR,
+						NRS_CTL_DRR_WR_QUANTUM, false,
+						&quantum_hp);
+		if ((rc2 < 0 && rc2 != -ENODEV) ||
+		    (rc2 == -ENODEV && queue == PTLRPC_NRS_QUEUE_HP))
+			return rc2;
+	}
+
+	return rc == -ENODEV && rc2 == -ENODEV ? -ENODEV : count;
+}
+LPROC_SEQ_FOPS(ptlrpc_lprocfs_nrs_drr_quantum);
+
+/**
+ * Retrieves the fixed per-RPC cost, in bytes, charged by DRR policy instances
+ * of a service.
+ *
+ * For example:
+ *
+ *	reg_rpc_cost:4096
+ *	hp_rpc_cost:4096
+ */
+static int
+ptlrpc_lprocfs_nrs_drr_rpc_cost_seq_show(struct seq_file *m, void *data)
+{
+	struct ptlrpc_service	*svc = m->private;
+	__u32			cost;
+	int			rc;
+
+	rc = ptlrpc_nrs_policy_control(svc, PTLRPC_NRS_QUEUE_REG,
+				       NRS_POL_NAME_DRR,
+				       NRS_CTL_DRR_RD_RPC_COST,
+				       true, &cost);
+	if (rc == 0)
+		seq_printf(m, "reg_rpc_cost:%u\n", cost);
+	else if (rc != -ENODEV)
+		return rc;
+
+	if (!nrs_svc_has_hp(svc))
+		return rc;
+
+	rc = ptlrpc_nrs_policy_control(svc, PTLRPC_NRS_QUEUE_HP,
+				       NRS_POL_NAME_DRR,
+				       NRS_CTL_DRR_RD_RPC_COST,
+				       true, &cost);
+	if (rc == 0)
+		seq_printf(m, "hp_rpc_cost:%u\n", cost);
+	else if (rc != -ENODEV)
+		return rc;
+
+	return rc;
+}
+
+/**
+ * Sets the fixed per-RPC cost, in bytes, of the DRR policy instances on both
+ * NRS heads of a service.
+ *
+ * For example:
+ *
+ * lctl set_param mds.MDS.mdt.nrs_drr_rpc_cost=65536, to make metadata RPCs
+ * as expensive as 64KB of bulk I/O.
+ */
+static ssize_t
+ptlrpc_lprocfs_nrs_drr_rpc_cost_seq_write(struct file *file,
+					  const char *buffer, size_t count,
+					  loff_t *off)
+{
+	struct ptlrpc_service	*svc = ((struct seq_file *)file->private_data)->private;
+	__u32			 cost;
+	int			 val;
+	int			 rc;
+	int			 rc2 = -ENODEV;
+
+	rc = lprocfs_write_helper(buffer, count, &val);
+	if (rc != 0)
+		return rc;
+
+	if (val < 0 || val > NRS_DRR_RPC_COST_MAX)
+		return -EINVAL;
+
+	cost = val;
+	/**
+	 * Change the regular and HP NRS heads separately, so that -ENODEV from
+	 * a head on which the policy is not started is not fatal; see
+	 * ptlrpc_lprocfs_nrs_drr_quantum_seq_write().
+	 */
+	rc = ptlrpc_nrs_policy_control(svc, PTLRPC_NRS_QUEUE_REG,
+				       NRS_POL_NAME_DRR,
+				       NRS_CTL_DRR_WR_RPC_COST, false, &cost);
+	if (rc < 0 && rc != -ENODEV)
+		return rc;
+
+	if (nrs_svc_has_hp(svc)) {
+		rc2 = ptlrpc_nrs_policy_control(svc, PTLRPC_NRS_QUEUE_HP,
+						NRS_POL_NAME_DRR,
+						NRS_CTL_DRR_WR_RPC_COST, false,
+						&cost);
+		if (rc2 < 0 && rc2 != -ENODEV)
+			return rc2;
+	}
+
+	return rc == -ENODEV && rc2 == -ENODEV ? -ENODEV : count;
+}
+LPROC_SEQ_FOPS(ptlrpc_lprocfs_nrs_drr_rpc_cost);
+
+/**
+ * Initializes a DRR policy's lprocfs interface for service \a svc
+ *
+ * \param[in] svc the service
+ *
+ * \retval 0	success
+ * \retval != 0	error
+ */
+static int nrs_drr_lprocfs_init(struct ptlrpc_service *svc)
+{
+	struct lprocfs_seq_vars nrs_drr_lprocfs_vars[] = {
+		{ .name		= "nrs_drr_quantum",
+		  .fops		= &ptlrpc_lprocfs_nrs_drr_quantum_fops,
+		  .data = svc },
+		{ .name		= "nrs_drr_rpc_cost",
+		  .fops		= &ptlrpc_lprocfs_nrs_drr_rpc_cost_fops,
+		  .data = svc },
+		{ NULL }
+	};
+
+	if (svc->srv_procroot == NULL)
+		return 0;
+
+	return lprocfs_seq_add_vars(svc->srv_procroot, nrs_drr_lprocfs_vars,
+				    NULL);
+}
+
+/**
+ * Cleans up a DRR policy's lprocfs interface for service \a svc
+ *
+ * \param[in] svc the service
+ */
+static void nrs_drr_lprocfs_fini(struct ptlrpc_service *svc)
+{
+	if (svc->srv_procroot == NULL)
+		return;
+
+	lprocfs_remove_proc_entry("nrs_drr_quantum", svc->srv_procroot);
+	lprocfs_remove_proc_entry("nrs_drr_rpc_cost", svc->srv_procroot);
+}
+
+#endif /* LPROCFS */
+
+/**
+ * DRR policy operations
+ */
+static const struct ptlrpc_nrs_pol_ops nrs_drr_ops = {
+	.op_policy_start	= nrs_drr_start,
+	.op_policy_stop		= nrs_drr_stop,
+	.op_policy_ctl		= nrs_drr_ctl,
+	.op_res_get		= nrs_drr_res_get,
+	.op_res_put		= nrs_drr_res_put,
+	.op_req_get		= nrs_drr_req_get,
+	.op_req_enqueue		= nrs_drr_req_add,
+	.op_req_dequeue		= nrs_drr_req_del,
+	.op_req_stop		= nrs_drr_req_stop,
+#ifdef LPROCFS
+	.op_lprocfs_init	= nrs_drr_lprocfs_init,
+	.op_lprocfs_fini	= nrs_drr_lprocfs_fini,
+#endif
+};
+
+/**
+ * DRR policy configuration
+ */
+struct ptlrpc_nrs_pol_conf nrs_conf_drr = {
+	.nc_name		= NRS_POL_NAME_DRR,
+	.nc_ops			= &nrs_drr_ops,
+	.nc_compat		= nrs_policy_compat_all,
+};
+
+/** @} DRR policy */
+
+/** @} nrs */
+
+#endif /* HAVE_SERVER_SUPPORT */
@@ -82,15 +82,23 @@ static enum hrtimer_restart nrs_tbf_timer_cb(struct hrtimer *timer)
 }
 
 #define NRS_TBF_DEFAULT_RULE "default"
+#define NRS_TBF_PARENT_PREFIX "parent="
+
+static void nrs_tbf_rule_put(struct nrs_tbf_rule *rule);
 
 static void nrs_tbf_rule_fini(struct nrs_tbf_rule *rule)
 {
+	struct nrs_tbf_rule *parent = rule->tr_parent;
+
 	LASSERT(atomic_read(&rule->tr_ref) == 0);
+	LASSERT(atomic_read(&rule->tr_nchildren) == 0);
 	LASSERT(list_empty(&rule->tr_cli_list));
 	LASSERT(list_empty(&rule->tr_linkage));
 
 	rule->tr_head->th_ops->o_rule_fini(rule);
 	OBD_FREE_PTR(rule);
+	if (parent != NULL)
+		nrs_tbf_rule_put(parent);
 }
 
 /**
@@ -163,7 +171,104 @@ nrs_tbf_cli_reset(struct nrs_tbf_head *head,
 static int
 nrs_tbf_rule_dump(struct nrs_tbf_rule *rule, struct seq_file *m)
 {
-	return rule->tr_head->th_ops->o_rule_dump(rule, m);
+	int rc;
+
+	rc = rule->tr_head->th_ops->o_rule_dump(rule, m);
+	if (rc)
+		return rc;
+
+	if (rule->tr_parent != NULL)
+		return seq_printf(m, ", parent %s, borrowed "LPU64"\n",
+				  rule->tr_parent->tr_name,
+				  rule->tr_nborrowed);
+
+	return seq_printf(m, "\n");
+}
+
+/**
+ * Refills the class bucket of \a rule with the tokens accumulated since its
+ * last check-point. The class bucket is shared by every client matching the
+ * rule or one of its descendants, and holds the capacity of the class that
+ * is currently unused.
+ */
+static void nrs_tbf_rule_refill(struct nrs_tbf_rule *rule, __u64 now)
+{
+	__u64 ntoken;
+
+	if (now <= rule->tr_check_time)
+		return;
+
+	ntoken = ((now - rule->tr_check_time) * rule->tr_rpc_rate) /
+		 NSEC_PER_SEC;
+	if (ntoken == 0)
+		return;
+
+	if (rule->tr_ntoken + ntoken >= rule->tr_depth) {
+		rule->tr_ntoken = rule->tr_depth;
+		rule->tr_check_time = now;
+	} else {
+		rule->tr_ntoken += ntoken;
+		rule->tr_check_time += ntoken * rule->tr_nsecs;
+	}
+}
+
+/**
+ * Charges an RPC dispatched by a client of \a rule to the class buckets of
+ * the rule itself and of all its ancestors, so that the RPCs of clients
+ * matching a parent rule directly are not lent again to its children. The
+ * client's guaranteed rate is always honoured, so an exhausted bucket is
+ * not an error; it only means there is nothing left for the descendants to
+ * borrow.
+ */
+static void nrs_tbf_rule_charge(struct nrs_tbf_rule *rule, __u64 now)
+{
+	for (; rule != NULL; rule = rule->tr_parent) {
+		nrs_tbf_rule_refill(rule, now);
+		if (rule->tr_ntoken > 0)
+			rule->tr_ntoken--;
+	}
+}
+
+/**
+ * Tries to borrow a token for a client of \a rule that has exhausted its
+ * own bucket. Borrowing succeeds only if every ancestor still has unused
+ * capacity, so a child can never exceed the rate of any of its ancestors.
+ *
+ * \param[in]  rule     the rule of the throttled client
+ * \param[in]  now      current time in nanoseconds
+ * \param[out] deadline when borrowing fails, the time at which all the
+ *			ancestors will have a token again
+ *
+ * \retval true  a token was borrowed and charged to the rule and to every
+ *		 ancestor
+ * \retval false at least one ancestor has no unused capacity
+ */
+static bool nrs_tbf_rule_borrow(struct nrs_tbf_rule *rule, __u64 now,
+				__u64 *deadline)
+{
+	struct nrs_tbf_rule *tmp;
+	bool		     ok = true;
+
+	if (rule->tr_parent == NULL)
+		return false;
+
+	*deadline = 0;
+	for (tmp = rule->tr_parent; tmp != NULL; tmp = tmp->tr_parent) {
+		nrs_tbf_rule_refill(tmp, now);
+		if (tmp->tr_ntoken == 0) {
+			ok = false;
+			if (*deadline < tmp->tr_check_time + tmp->tr_nsecs)
+				*deadline = tmp->tr_check_time + tmp->tr_nsecs;
+		}
+	}
+
+	if (!ok)
+		return false;
+
+	nrs_tbf_rule_charge(rule, now);
+	rule->tr_nborrowed++;
+
+	return true;
 }
 
 static int
@@ -275,6 +380,8 @@ nrs_tbf_rule_start(struct ptlrpc_nrs_policy *policy,
 		   struct nrs_tbf_cmd *start)
 {
 	struct nrs_tbf_rule *rule, *tmp_rule;
+	struct nrs_tbf_rule *parent = NULL;
+	int depth = 1;
 	int rc;
 
 	rule = nrs_tbf_rule_find(head, start->tc_name);
@@ -283,35 +390,71 @@ nrs_tbf_rule_start(struct ptlrpc_nrs_policy *policy,
 		return -EEXIST;
 	}
 
+	if (start->tc_parent_name != NULL) {
+		parent = nrs_tbf_rule_find(head, start->tc_parent_name);
+		if (parent == NULL)
+			return -ENOENT;
+
+		for (tmp_rule = parent; tmp_rule != NULL;
+		     tmp_rule = tmp_rule->tr_parent)
+			depth++;
+		if (depth > NRS_TBF_RULE_DEPTH_MAX) {
+			nrs_tbf_rule_put(parent);
+			return -E2BIG;
+		}
+	}
+
 	OBD_CPT_ALLOC_PTR(rule, nrs_pol2cptab(policy), nrs_pol2cptid(policy));
-	if (rule == NULL)
+	if (rule == NULL) {
+		if (parent != NULL)
+			nrs_tbf_rule_put(parent);
 		return -ENOMEM;
+	}
 
 	memcpy(rule->tr_name, start->tc_name, strlen(start->tc_name));
 	rule->tr_rpc_rate = start->tc_rpc_rate;
 	rule->tr_nsecs = NSEC_PER_SEC / rule->tr_rpc_rate;
 	rule->tr_depth = tbf_depth;
+	rule->tr_ntoken = rule->tr_depth;
+	rule->tr_check_time = ktime_to_ns(ktime_get());
 	atomic_set(&rule->tr_ref, 1);
+	atomic_set(&rule->tr_nchildren, 0);
 	INIT_LIST_HEAD(&rule->tr_cli_list);
 	INIT_LIST_HEAD(&rule->tr_nids);
 
 	rc = head->th_ops->o_rule_init(policy, rule, start);
 	if (rc) {
 		OBD_FREE_PTR(rule);
+		if (parent != NULL)
+			nrs_tbf_rule_put(parent);
 		return rc;
 	}
 
 	/* Add as the newest rule */
 	spin_lock(&head->th_rule_lock);
+	rule->tr_head = head;
 	tmp_rule = nrs_tbf_rule_find_nolock(head, start->tc_name);
 	if (tmp_rule) {
 		spin_unlock(&head->th_rule_lock);
 		nrs_tbf_rule_put(tmp_rule);
+		if (parent != NULL)
+			nrs_tbf_rule_put(parent);
 		nrs_tbf_rule_put(rule);
 		return -EEXIST;
 	}
+	if (parent != NULL) {
+		/* The parent may have been stopped while unlocked */
+		if (parent->tr_flags & NTRS_STOPPING) {
+			spin_unlock(&head->th_rule_lock);
+			nrs_tbf_rule_put(parent);
+			nrs_tbf_rule_put(rule);
+			return -ENOENT;
+		}
+		/* Takes over the reference from nrs_tbf_rule_find() */
+		rule->tr_parent = parent;
+		atomic_inc(&parent->tr_nchildren);
+	}
 	list_add(&rule->tr_linkage, &head->th_list);
-	rule->tr_head = head;
 	spin_unlock(&head->th_rule_lock);
 	atomic_inc(&head->th_rule_sequence);
 	if (start->tc_rule_flags & NTRS_DEFAULT) {
@@ -360,8 +503,20 @@ nrs_tbf_rule_stop(struct ptlrpc_nrs_policy *policy,
 	if (rule == NULL)
 		return -ENOENT;
 
+	spin_lock(&head->th_rule_lock);
+	/* Children keep borrowing from the parent, stop them first. Checked
+	 * under th_rule_lock, which nrs_tbf_rule_start() holds to attach a
+	 * child, so that no child can be attached to a stopping rule. */
+	if (atomic_read(&rule->tr_nchildren) > 0) {
+		spin_unlock(&head->th_rule_lock);
+		nrs_tbf_rule_put(rule);
+		return -EBUSY;
+	}
 	list_del_init(&rule->tr_linkage);
 	rule->tr_flags |= NTRS_STOPPING;
+	if (rule->tr_parent != NULL)
+		atomic_dec(&rule->tr_parent->tr_nchildren);
+	spin_unlock(&head->th_rule_lock);
 	nrs_tbf_rule_put(rule);
 	nrs_tbf_rule_put(rule);
 
@@ -822,7 +977,7 @@ static int nrs_tbf_jobid_rule_init(struct ptlrpc_nrs_policy *policy,
 static int
 nrs_tbf_jobid_rule_dump(struct nrs_tbf_rule *rule, struct seq_file *m)
 {
-	return seq_printf(m, "%s {%s} %llu, ref %d\n", rule->tr_name,
+	return seq_printf(m, "%s {%s} %llu, ref %d", rule->tr_name,
 			  rule->tr_jobids_str, rule->tr_rpc_rate,
 			  atomic_read(&rule->tr_ref) - 1);
 }
@@ -1027,7 +1182,7 @@ static int nrs_tbf_nid_rule_init(struct ptlrpc_nrs_policy *policy,
 static int
 nrs_tbf_nid_rule_dump(struct nrs_tbf_rule *rule, struct seq_file *m)
 {
-	return seq_printf(m, "%s {%s} %llu, ref %d\n", rule->tr_name,
+	return seq_printf(m, "%s {%s} %llu, ref %d", rule->tr_name,
 			  rule->tr_nids_str, rule->tr_rpc_rate,
 			  atomic_read(&rule->tr_ref) - 1);
 }
@@ -1390,6 +1545,7 @@ struct ptlrpc_nrs_request *nrs_tbf_req_get(struct ptlrpc_nrs_policy *policy,
 		__u64 passed;
 		long  ntoken;
 		__u64 deadline;
+		__u64 borrow_deadline = 0;
 
 		deadline = cli->tc_check_time +
 			  cli->tc_nsecs;
@@ -1399,6 +1555,20 @@ struct ptlrpc_nrs_request *nrs_tbf_req_get(struct ptlrpc_nrs_policy *policy,
 		ntoken += cli->tc_ntoken;
 		if (ntoken > cli->tc_depth)
 			ntoken = cli->tc_depth;
+		if (ntoken > 0) {
+			ntoken--;
+			cli->tc_ntoken = ntoken;
+			cli->tc_check_time = now;
+			nrs_tbf_rule_charge(cli->tc_rule, now);
+		} else if (nrs_tbf_rule_borrow(cli->tc_rule, now,
+					       &borrow_deadline)) {
+			/* Own bucket empty, run on capacity of ancestors */
+			ntoken = 1;
+		} else if (cli->tc_rule->tr_parent != NULL &&
+			   borrow_deadline < deadline) {
+			deadline = borrow_deadline;
+		}
+
 		if (ntoken > 0) {
 			struct ptlrpc_request *req;
 			nrq = list_entry(cli->tc_list.next,
@@ -1407,9 +1577,6 @@ struct ptlrpc_nrs_request *nrs_tbf_req_get(struct ptlrpc_nrs_policy *policy,
 			req = container_of(nrq,
 					   struct ptlrpc_request,
 					   rq_nrq);
-			ntoken--;
-			cli->tc_ntoken = ntoken;
-			cli->tc_check_time = now;
 			list_del_init(&nrq->nr_u.tbf.tr_list);
 			if (list_empty(&cli->tc_list)) {
 				cfs_binheap_remove(head->th_binheap,
@@ -1718,16 +1885,48 @@ nrs_tbf_parse_cmd(char *buffer, unsigned long count)
 			GOTO(out_free_cmd, rc);
 	}
 
-	if (val != NULL) {
-		if (cmd->tc_cmd == NRS_CTL_TBF_STOP_RULE ||
-		    strlen(val) == 0 || !isdigit(val[0]))
+	if (val != NULL && cmd->tc_cmd == NRS_CTL_TBF_STOP_RULE)
+		GOTO(out_free_nid, rc = -EINVAL);
+
+	/* Optional RPC rate and "parent=<rule>", in any order */
+	while (val != NULL) {
+		token = strsep(&val, " ");
+		if (strlen(token) == 0)
+			continue;
+
+		if (strncmp(token, NRS_TBF_PARENT_PREFIX,
+			    strlen(NRS_TBF_PARENT_PREFIX)) == 0) {
+			if (cmd->tc_cmd != NRS_CTL_TBF_START_RULE ||
+			    cmd->tc_parent_name != NULL)
+				GOTO(out_free_nid, rc = -EINVAL);
+
+			token += strlen(NRS_TBF_PARENT_PREFIX);
+			i = strlen(token);
+			if (i > 0 && token[i - 1] == '\n')
+				token[--i] = '\0';
+			if (i == 0 || i >= MAX_TBF_NAME)
+				GOTO(out_free_nid, rc = -EINVAL);
+			for (i = 0; i < strlen(token); i++) {
+				if ((!isalnum(token[i])) &&
+				    (token[i] != '_'))
+					GOTO(out_free_nid, rc = -EINVAL);
+			}
+			if (strcmp(token, cmd->tc_name) == 0)
+				GOTO(out_free_nid, rc = -EINVAL);
+			cmd->tc_parent_name = token;
+			continue;
+		}
+
+		if (cmd->tc_rpc_rate != 0 || !isdigit(token[0]))
 			GOTO(out_free_nid, rc = -EINVAL);
 
-		cmd->tc_rpc_rate = simple_strtoull(val, NULL, 10);
+		cmd->tc_rpc_rate = simple_strtoull(token, NULL, 10);
 		if (cmd->tc_rpc_rate <= 0 ||
 		    cmd->tc_rpc_rate >= LPROCFS_NRS_RATE_MAX)
 			GOTO(out_free_nid, rc = -EINVAL);
-	} else {
+	}
+
+	if (cmd->tc_rpc_rate == 0) {
 		if (cmd->tc_cmd == NRS_CTL_TBF_CHANGE_RATE)
 			GOTO(out_free_nid, rc = -EINVAL);
 		/* No RPC rate given */
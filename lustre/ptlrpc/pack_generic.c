@@ -328,6 +328,56 @@ void lustre_put_emerg_rs(struct ptlrpc_reply_state *rs)
 	wake_up(&svcpt->scp_rep_waitq);
 }
 
+/**
+ * Get a zeroed reply state of srv_rs_recycle_size, reusing one freed earlier
+ * by \a svcpt if possible; unlike lustre_get_emerg_rs() this never waits.
+ */
+struct ptlrpc_reply_state *
+lustre_get_recycled_rs(struct ptlrpc_service_part *svcpt)
+{
+	struct ptlrpc_reply_state *rs = NULL;
+
+	spin_lock(&svcpt->scp_rep_lock);
+	if (!list_empty(&svcpt->scp_rep_free)) {
+		rs = list_entry(svcpt->scp_rep_free.next,
+				struct ptlrpc_reply_state, rs_list);
+		list_del(&rs->rs_list);
+		svcpt->scp_nreps_free--;
+	}
+	spin_unlock(&svcpt->scp_rep_lock);
+
+	if (rs != NULL) {
+		memset(rs, 0, svcpt->scp_service->srv_rs_recycle_size);
+	} else {
+		OBD_ALLOC_LARGE(rs, svcpt->scp_service->srv_rs_recycle_size);
+		if (rs == NULL)
+			return NULL;
+	}
+
+	rs->rs_size = svcpt->scp_service->srv_rs_recycle_size;
+	rs->rs_svcpt = svcpt;
+	rs->rs_prealloc = 1;
+	rs->rs_recycle = 1;
+
+	return rs;
+}
+
+void lustre_put_recycled_rs(struct ptlrpc_reply_state *rs)
+{
+	struct ptlrpc_service_part *svcpt = rs->rs_svcpt;
+
+	spin_lock(&svcpt->scp_rep_lock);
+	if (svcpt->scp_nreps_free < PTLRPC_SVC_RECYCLE_MAX) {
+		list_add(&rs->rs_list, &svcpt->scp_rep_free);
+		svcpt->scp_nreps_free++;
+		rs = NULL;
+	}
+	spin_unlock(&svcpt->scp_rep_lock);
+
+	if (rs != NULL)
+		OBD_FREE_LARGE(rs, rs->rs_size);
+}
+
 int lustre_pack_reply_v2(struct ptlrpc_request *req, int count,
                          __u32 *lens, char **bufs, int flags)
 {
@@ -354,6 +404,7 @@ int lustre_pack_reply_v2(struct ptlrpc_request *req, int count,
 	rs->rs_cb_id.cbid_arg = rs;
 	rs->rs_svcpt = req->rq_rqbd->rqbd_svcpt;
 	INIT_LIST_HEAD(&rs->rs_exp_list);
+	INIT_HLIST_NODE(&rs->rs_xid_hash);
 	INIT_LIST_HEAD(&rs->rs_obd_list);
 	INIT_LIST_HEAD(&rs->rs_list);
 	spin_lock_init(&rs->rs_lock);
@@ -518,6 +569,7 @@ void lustre_free_reply_state(struct ptlrpc_reply_state *rs)
 	LASSERT(rs->rs_export == NULL);
 	LASSERT(rs->rs_nlocks == 0);
 	LASSERT(list_empty(&rs->rs_exp_list));
+	LASSERT(hlist_unhashed(&rs->rs_xid_hash));
 	LASSERT(list_empty(&rs->rs_obd_list));
 
 	sptlrpc_svc_free_rs(rs);
@@ -55,6 +55,7 @@ extern struct ptlrpc_nrs_pol_conf nrs_conf_crrn;
 extern struct ptlrpc_nrs_pol_conf nrs_conf_orr;
 extern struct ptlrpc_nrs_pol_conf nrs_conf_trr;
 extern struct ptlrpc_nrs_pol_conf nrs_conf_tbf;
+extern struct ptlrpc_nrs_pol_conf nrs_conf_drr;
 #endif /* HAVE_SERVER_SUPPORT */
 
 /**
@@ -67,8 +68,10 @@ extern struct mutex ptlrpcd_mutex;
 extern struct mutex pinger_mutex;
 
 int ptlrpc_start_thread(struct ptlrpc_service_part *svcpt, int wait);
+struct ptlrpc_request *ptlrpc_srv_req_alloc(struct ptlrpc_service_part *svcpt);
 /* ptlrpcd.c */
 int ptlrpcd_start(int index, int max, const char *name, struct ptlrpcd_ctl *pc);
+void ptlrpcd_steal_wake(struct ptlrpcd_ctl *pc, int before, int after);
 
 /* client.c */
 void ptlrpc_at_adj_net_latency(struct ptlrpc_request *req,
@@ -158,6 +161,19 @@ ptlrpc_nrs_req_peek_nolock(struct ptlrpc_service_part *svcpt, bool hp)
 }
 
 void ptlrpc_nrs_req_del_nolock(struct ptlrpc_request *req);
+
+/* nrs_fifo.c */
+int nrs_fifo_ring_init(struct ptlrpc_nrs *nrs);
+void nrs_fifo_ring_fini(struct ptlrpc_nrs *nrs);
+int nrs_fifo_ring_push(struct ptlrpc_nrs *nrs, struct ptlrpc_nrs_request *nrq);
+struct ptlrpc_nrs_request *nrs_fifo_ring_pop(struct nrs_fifo_ring *ring);
+
+static inline bool nrs_fifo_ring_empty(struct nrs_fifo_ring *ring)
+{
+	return ring == NULL ||
+	       ACCESS_ONCE(ring->fr_head) == ACCESS_ONCE(ring->fr_tail);
+}
+
 bool ptlrpc_nrs_req_pending_nolock(struct ptlrpc_service_part *svcpt, bool hp);
 bool ptlrpc_nrs_req_throttling_nolock(struct ptlrpc_service_part *svcpt,
 				      bool hp);
@@ -258,6 +274,9 @@ void ptlrpc_add_bulk_page(struct ptlrpc_bulk_desc *desc, struct page *page,
 struct ptlrpc_reply_state *
 lustre_get_emerg_rs(struct ptlrpc_service_part *svcpt);
 void lustre_put_emerg_rs(struct ptlrpc_reply_state *rs);
+struct ptlrpc_reply_state *
+lustre_get_recycled_rs(struct ptlrpc_service_part *svcpt);
+void lustre_put_recycled_rs(struct ptlrpc_reply_state *rs);
 
 /* pinger.c */
 int ptlrpc_start_pinger(void);
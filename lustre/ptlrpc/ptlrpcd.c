@@ -83,6 +83,15 @@ CFS_MODULE_PARM(ptlrpcd_bind_policy, "i", int, 0644,
                 "Ptlrpcd threads binding mode.");
 static struct ptlrpcd *ptlrpcds;
 
+/*
+ * An idle ptlrpcd thread steals async RPCs from any peer which has at least
+ * this many new RPCs queued, not only from its partners. 0 disables it.
+ */
+static int ptlrpcd_steal_depth = 4;
+CFS_MODULE_PARM(ptlrpcd_steal_depth, "i", int, 0644,
+		"Queued RPCs for a ptlrpcd thread to be stolen from by idle "
+		"peers (0 to disable).");
+
 struct mutex ptlrpcd_mutex;
 static int ptlrpcd_users = 0;
 
@@ -146,7 +155,7 @@ void ptlrpcd_add_rqset(struct ptlrpc_request_set *set)
 	struct list_head *tmp, *pos;
         struct ptlrpcd_ctl *pc;
         struct ptlrpc_request_set *new;
-        int count, i;
+	int count, added, i;
 
         pc = ptlrpcd_select_pc(NULL, PDL_POLICY_LOCAL, -1);
         new = pc->pc_set;
@@ -163,11 +172,11 @@ void ptlrpcd_add_rqset(struct ptlrpc_request_set *set)
 
 	spin_lock(&new->set_new_req_lock);
 	list_splice_init(&set->set_requests, &new->set_new_requests);
-	i = atomic_read(&set->set_remaining);
-	count = atomic_add_return(i, &new->set_new_count);
+	added = atomic_read(&set->set_remaining);
+	count = atomic_add_return(added, &new->set_new_count);
 	atomic_set(&set->set_remaining, 0);
 	spin_unlock(&new->set_new_req_lock);
-	if (count == i) {
+	if (count == added) {
 		wake_up(&new->set_waitq);
 
 		/* XXX: It maybe unnecessary to wakeup all the partners. But to
@@ -176,14 +185,23 @@ void ptlrpcd_add_rqset(struct ptlrpc_request_set *set)
 		for (i = 0; i < pc->pc_npartners; i++)
 			wake_up(&pc->pc_partners[i]->pc_set->set_waitq);
 	}
+
+	ptlrpcd_steal_wake(pc, count - added, count);
 }
 EXPORT_SYMBOL(ptlrpcd_add_rqset);
 
+static inline void ptlrpc_reqset_get(struct ptlrpc_request_set *set)
+{
+	atomic_inc(&set->set_refcount);
+}
+
 /**
+ * Move at most \a max (all if \a max is 0) new RPCs of \a src into \a des,
+ * oldest first.
  * Return transferred RPCs count.
  */
 static int ptlrpcd_steal_rqset(struct ptlrpc_request_set *des,
-                               struct ptlrpc_request_set *src)
+			       struct ptlrpc_request_set *src, int max)
 {
 	struct list_head *tmp, *pos;
 	struct ptlrpc_request *req;
@@ -192,20 +210,140 @@ static int ptlrpcd_steal_rqset(struct ptlrpc_request_set *des,
 	spin_lock(&src->set_new_req_lock);
 	if (likely(!list_empty(&src->set_new_requests))) {
 		list_for_each_safe(pos, tmp, &src->set_new_requests) {
+			if (max > 0 && rc >= max)
+				break;
+
 			req = list_entry(pos, struct ptlrpc_request,
 					 rq_set_chain);
 			req->rq_set = des;
+			list_move_tail(&req->rq_set_chain, &des->set_requests);
+			rc++;
 		}
-		list_splice_init(&src->set_new_requests,
-				 &des->set_requests);
-		rc = atomic_read(&src->set_new_count);
 		atomic_add(rc, &des->set_remaining);
-		atomic_set(&src->set_new_count, 0);
+		atomic_sub(rc, &src->set_new_count);
 	}
 	spin_unlock(&src->set_new_req_lock);
 	return rc;
 }
 
+static inline int ptlrpcd_distance(struct ptlrpcd_ctl *pc,
+				   struct ptlrpcd_ctl *peer)
+{
+#if defined(CONFIG_NUMA)
+	return node_distance(pc->pc_node, peer->pc_node);
+#else
+	return LOCAL_DISTANCE;
+#endif
+}
+
+/**
+ * Called when the new RPCs queued on \a pc went from \a before to \a after;
+ * if \a pc just became overloaded, wake up the nearest idle ptlrpcd thread,
+ * so that it steals some of them.
+ */
+void ptlrpcd_steal_wake(struct ptlrpcd_ctl *pc, int before, int after)
+{
+	struct ptlrpcd_ctl *idle = NULL;
+	int best = INT_MAX;
+	int i;
+
+	if (ptlrpcd_steal_depth <= 0 || before >= ptlrpcd_steal_depth ||
+	    after < ptlrpcd_steal_depth)
+		return;
+
+	if (ptlrpcds == NULL || test_bit(LIOD_RECOVERY, &pc->pc_flags))
+		return;
+
+	for (i = 0; i < ptlrpcds->pd_nthreads; i++) {
+		struct ptlrpcd_ctl *peer = &ptlrpcds->pd_threads[i];
+		int distance;
+
+		if (peer == pc || !peer->pc_idle)
+			continue;
+
+		distance = ptlrpcd_distance(pc, peer);
+		if (distance < best) {
+			best = distance;
+			idle = peer;
+			if (distance == LOCAL_DISTANCE)
+				break;
+		}
+	}
+
+	if (idle != NULL) {
+		spin_lock(&idle->pc_lock);
+		if (idle->pc_set != NULL)
+			wake_up(&idle->pc_set->set_waitq);
+		spin_unlock(&idle->pc_lock);
+	}
+}
+
+/**
+ * Steal half of the new async RPCs of the most loaded peer, if any has at
+ * least ptlrpcd_steal_depth of them. The load of remote NUMA nodes is scaled
+ * down by their distance, so near peers are preferred.
+ *
+ * Return transferred RPCs count.
+ */
+static int ptlrpcd_steal_peer(struct ptlrpcd_ctl *pc)
+{
+	struct ptlrpcd_ctl *victim = NULL;
+	struct ptlrpc_request_set *ps;
+	int best = 0;
+	int depth;
+	int rc = 0;
+	int i;
+
+	for (i = 0; i < ptlrpcds->pd_nthreads; i++) {
+		struct ptlrpcd_ctl *peer = &ptlrpcds->pd_threads[i];
+
+		if (peer == pc)
+			continue;
+
+		spin_lock(&peer->pc_lock);
+		depth = peer->pc_set != NULL ?
+			atomic_read(&peer->pc_set->set_new_count) : 0;
+		spin_unlock(&peer->pc_lock);
+
+		if (depth < ptlrpcd_steal_depth)
+			continue;
+
+		depth = depth * LOCAL_DISTANCE / ptlrpcd_distance(pc, peer);
+		if (depth > best) {
+			best = depth;
+			victim = peer;
+		}
+	}
+
+	if (victim == NULL)
+		return 0;
+
+	spin_lock(&victim->pc_lock);
+	ps = victim->pc_set;
+	if (ps == NULL) {
+		spin_unlock(&victim->pc_lock);
+		return 0;
+	}
+	ptlrpc_reqset_get(ps);
+	spin_unlock(&victim->pc_lock);
+
+	depth = atomic_read(&ps->set_new_count);
+	if (depth >= ptlrpcd_steal_depth) {
+		rc = ptlrpcd_steal_rqset(pc->pc_set, ps, (depth + 1) / 2);
+		if (rc > 0) {
+			pc->pc_steal_peer += rc;
+			spin_lock(&victim->pc_lock);
+			victim->pc_stolen += rc;
+			spin_unlock(&victim->pc_lock);
+			CDEBUG(D_RPCTRACE, "steal %d async RPCs [%d->%d]\n",
+			       rc, victim->pc_index, pc->pc_index);
+		}
+	}
+	ptlrpc_reqset_put(ps);
+
+	return rc;
+}
+
 /**
  * Requests that are added to the ptlrpcd queue are sent via
  * ptlrpcd_check->ptlrpc_check_set().
@@ -249,11 +387,6 @@ void ptlrpcd_add_req(struct ptlrpc_request *req, pdl_policy_t policy, int idx)
 }
 EXPORT_SYMBOL(ptlrpcd_add_req);
 
-static inline void ptlrpc_reqset_get(struct ptlrpc_request_set *set)
-{
-	atomic_inc(&set->set_refcount);
-}
-
 /**
  * Check if there is more work to do on ptlrpcd set.
  * Returns 1 if yes.
@@ -348,18 +481,31 @@ static int ptlrpcd_check(struct lu_env *env, struct ptlrpcd_ctl *pc)
 				spin_unlock(&partner->pc_lock);
 
 				if (atomic_read(&ps->set_new_count)) {
-					rc = ptlrpcd_steal_rqset(set, ps);
-					if (rc > 0)
+					rc = ptlrpcd_steal_rqset(set, ps, 0);
+					if (rc > 0) {
+						pc->pc_steal_partner += rc;
+						spin_lock(&partner->pc_lock);
+						partner->pc_stolen += rc;
+						spin_unlock(&partner->pc_lock);
 						CDEBUG(D_RPCTRACE, "transfer %d"
 						       " async RPCs [%d->%d]\n",
 						       rc, partner->pc_index,
 						       pc->pc_index);
+					}
 				}
 				ptlrpc_reqset_put(ps);
 			} while (rc == 0 && pc->pc_cursor != first);
 		}
+
+		/* Still nothing to do, look for any overloaded peer. */
+		if (rc == 0 && ptlrpcd_steal_depth > 0 &&
+		    !test_bit(LIOD_RECOVERY, &pc->pc_flags) &&
+		    !test_bit(LIOD_STOP, &pc->pc_flags))
+			rc = ptlrpcd_steal_peer(pc);
 	}
 
+	pc->pc_idle = rc == 0;
+
 	RETURN(rc);
 }
 
@@ -613,6 +759,11 @@ int ptlrpcd_start(int index, int max, const char *name, struct ptlrpcd_ctl *pc)
 	}
 
 	pc->pc_index = index;
+	pc->pc_node = 0;
+#if defined(CONFIG_NUMA)
+	if (index >= 0 && index < num_possible_cpus())
+		pc->pc_node = cpu_to_node(index);
+#endif
 	init_completion(&pc->pc_starting);
 	init_completion(&pc->pc_finishing);
 	spin_lock_init(&pc->pc_lock);
@@ -717,12 +868,50 @@ out:
         EXIT;
 }
 
+#ifdef LPROCFS
+static int ptlrpcd_stats_seq_show(struct seq_file *m, void *data)
+{
+	int i;
+
+	/* the entry only exists while ptlrpcds is set up */
+	for (i = 0; i < ptlrpcds->pd_nthreads; i++) {
+		struct ptlrpcd_ctl *pc = &ptlrpcds->pd_threads[i];
+		int depth = 0;
+		__u64 stolen;
+
+		spin_lock(&pc->pc_lock);
+		if (pc->pc_set != NULL)
+			depth = atomic_read(&pc->pc_set->set_new_count) +
+				atomic_read(&pc->pc_set->set_remaining);
+		stolen = pc->pc_stolen;
+		spin_unlock(&pc->pc_lock);
+
+		seq_printf(m, "- name: %s\n"
+			   "  node: %d\n"
+			   "  queue_depth: %d\n"
+			   "  steal_partner: "LPU64"\n"
+			   "  steal_peer: "LPU64"\n"
+			   "  stolen: "LPU64"\n",
+			   pc->pc_name, pc->pc_node, depth,
+			   pc->pc_steal_partner, pc->pc_steal_peer, stolen);
+	}
+
+	return 0;
+}
+LPROC_SEQ_FOPS_RO(ptlrpcd_stats);
+#endif /* LPROCFS */
+
 static void ptlrpcd_fini(void)
 {
 	int i;
 	ENTRY;
 
 	if (ptlrpcds != NULL) {
+#ifdef LPROCFS
+		if (proc_lustre_root != NULL)
+			lprocfs_remove_proc_entry("ptlrpcd_stats",
+						  proc_lustre_root);
+#endif
 		for (i = 0; i < ptlrpcds->pd_nthreads; i++)
 			ptlrpcd_stop(&ptlrpcds->pd_threads[i], 0);
 		for (i = 0; i < ptlrpcds->pd_nthreads; i++)
@@ -786,6 +975,17 @@ static int ptlrpcd_init(void)
         ptlrpcds->pd_index = 0;
         ptlrpcds->pd_nthreads = nthreads;
 
+#ifdef LPROCFS
+	if (proc_lustre_root != NULL) {
+		rc = lprocfs_seq_create(proc_lustre_root, "ptlrpcd_stats",
+					0444, &ptlrpcd_stats_fops, NULL);
+		if (rc != 0) {
+			CWARN("cannot create ptlrpcd_stats: rc = %d\n", rc);
+			rc = 0;
+		}
+	}
+#endif
+
 out:
         if (rc != 0 && ptlrpcds != NULL) {
                 for (j = 0; j <= i; j++)
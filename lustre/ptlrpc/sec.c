@@ -2117,6 +2117,7 @@ int sptlrpc_svc_unwrap_request(struct ptlrpc_request *req)
  */
 int sptlrpc_svc_alloc_rs(struct ptlrpc_request *req, int msglen)
 {
+	struct ptlrpc_service_part *svcpt;
         struct ptlrpc_sec_policy *policy;
         struct ptlrpc_reply_state *rs;
         int rc;
@@ -2128,9 +2129,18 @@ int sptlrpc_svc_alloc_rs(struct ptlrpc_request *req, int msglen)
         policy = req->rq_svc_ctx->sc_policy;
         LASSERT(policy->sp_sops->alloc_rs);
 
+	/* replies that fit are packed into a recycled reply state */
+	svcpt = req->rq_rqbd->rqbd_svcpt;
+	if (msglen + sizeof(struct ptlrpc_reply_state) + SPTLRPC_MAX_PAYLOAD <=
+	    svcpt->scp_service->srv_rs_recycle_size)
+		req->rq_reply_state = lustre_get_recycled_rs(svcpt);
+
         rc = policy->sp_sops->alloc_rs(req, msglen);
+	if (unlikely(rc != 0 && req->rq_reply_state != NULL)) {
+		lustre_put_recycled_rs(req->rq_reply_state);
+		req->rq_reply_state = NULL;
+	}
         if (unlikely(rc == -ENOMEM)) {
-		struct ptlrpc_service_part *svcpt = req->rq_rqbd->rqbd_svcpt;
 		if (svcpt->scp_service->srv_max_reply_size <
 		   msglen + sizeof(struct ptlrpc_reply_state)) {
 			/* Just return failure if the size is too big */
@@ -2190,6 +2200,7 @@ void sptlrpc_svc_free_rs(struct ptlrpc_reply_state *rs)
 {
         struct ptlrpc_sec_policy *policy;
         unsigned int prealloc;
+	unsigned int recycle;
         ENTRY;
 
         LASSERT(rs->rs_svc_ctx);
@@ -2199,9 +2210,12 @@ void sptlrpc_svc_free_rs(struct ptlrpc_reply_state *rs)
         LASSERT(policy->sp_sops->free_rs);
 
         prealloc = rs->rs_prealloc;
+	recycle = rs->rs_recycle;
         policy->sp_sops->free_rs(rs);
 
-        if (prealloc)
+	if (recycle)
+		lustre_put_recycled_rs(rs);
+	else if (prealloc)
                 lustre_put_emerg_rs(rs);
         EXIT;
 }
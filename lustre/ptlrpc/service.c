@@ -613,6 +613,7 @@ ptlrpc_service_part_init(struct ptlrpc_service *svc,
 	INIT_LIST_HEAD(&svcpt->scp_rqbd_idle);
 	INIT_LIST_HEAD(&svcpt->scp_rqbd_posted);
 	INIT_LIST_HEAD(&svcpt->scp_req_incoming);
+	INIT_LIST_HEAD(&svcpt->scp_req_free);
 	init_waitqueue_head(&svcpt->scp_waitq);
 	/* history request & rqbd list */
 	INIT_LIST_HEAD(&svcpt->scp_hist_reqs);
@@ -626,6 +627,7 @@ ptlrpc_service_part_init(struct ptlrpc_service *svc,
 	INIT_LIST_HEAD(&svcpt->scp_rep_active);
 	INIT_LIST_HEAD(&svcpt->scp_rep_idle);
 	init_waitqueue_head(&svcpt->scp_rep_waitq);
+	INIT_LIST_HEAD(&svcpt->scp_rep_free);
 	atomic_set(&svcpt->scp_nreps_difficult, 0);
 
 	/* adaptive timeout */
@@ -776,9 +778,21 @@ ptlrpc_register_service(struct ptlrpc_service_conf *conf,
 	       conf->psc_buf.bc_rep_max_size + SPTLRPC_MAX_PAYLOAD)
 		service->srv_max_reply_size <<= 1;
 
+	/* Reply states big enough for the reply of any RPC carrying no
+	 * variable-size data are recycled by the service partitions */
+	service->srv_rs_recycle_size = 1;
+	while (service->srv_rs_recycle_size <
+	       sizeof(struct ptlrpc_reply_state) +
+	       req_layout_fixed_reply_size() + SPTLRPC_MAX_PAYLOAD)
+		service->srv_rs_recycle_size <<= 1;
+	service->srv_rs_recycle_size = min(service->srv_rs_recycle_size,
+					   service->srv_max_reply_size);
+
 	service->srv_thread_name	= conf->psc_thr.tc_thr_name;
 	service->srv_ctx_tags		= conf->psc_thr.tc_ctx_tags;
 	service->srv_hpreq_ratio	= PTLRPC_SVC_HP_RATIO;
+	service->srv_batch_max		= PTLRPC_SVC_BATCH_MAX;
+	service->srv_qwait_target	= PTLRPC_SVC_QWAIT_TARGET;
 	service->srv_ops		= conf->psc_ops;
 
 	for (i = 0; i < ncpts; i++) {
@@ -830,6 +844,57 @@ failed:
 }
 EXPORT_SYMBOL(ptlrpc_register_service);
 
+/**
+ * Get a zeroed request structure for an incoming request of \a svcpt, reusing
+ * one freed by the partition if there is any.
+ */
+struct ptlrpc_request *ptlrpc_srv_req_alloc(struct ptlrpc_service_part *svcpt)
+{
+	struct ptlrpc_request *req = NULL;
+
+	spin_lock(&svcpt->scp_lock);
+	if (!list_empty(&svcpt->scp_req_free)) {
+		req = list_entry(svcpt->scp_req_free.next,
+				 struct ptlrpc_request, rq_list);
+		/* rq_list is reinitialized by ptlrpc_srv_req_init() */
+		list_del(&req->rq_list);
+		svcpt->scp_nreqs_free--;
+	}
+	spin_unlock(&svcpt->scp_lock);
+
+	if (req == NULL)
+		req = ptlrpc_request_cache_alloc(ALLOC_ATOMIC_TRY);
+
+	return req;
+}
+
+/**
+ * Keep \a req for reuse by ptlrpc_srv_req_alloc(), unless the partition has
+ * enough of them already.
+ */
+static void ptlrpc_srv_req_recycle(struct ptlrpc_service_part *svcpt,
+				   struct ptlrpc_request *req)
+{
+	if (svcpt->scp_nreqs_free >= PTLRPC_SVC_RECYCLE_MAX) {
+		ptlrpc_request_cache_free(req);
+		return;
+	}
+
+	/* zero it outside of scp_lock, incoming requests rely on it */
+	memset(req, 0, sizeof(*req));
+
+	spin_lock(&svcpt->scp_lock);
+	if (svcpt->scp_nreqs_free < PTLRPC_SVC_RECYCLE_MAX) {
+		list_add(&req->rq_list, &svcpt->scp_req_free);
+		svcpt->scp_nreqs_free++;
+		req = NULL;
+	}
+	spin_unlock(&svcpt->scp_lock);
+
+	if (req != NULL)
+		ptlrpc_request_cache_free(req);
+}
+
 /**
  * to actually free the request, must be called without holding svc_lock.
  * note it's caller's responsibility to unlink req->rq_list.
@@ -849,7 +914,7 @@ static void ptlrpc_server_free_request(struct ptlrpc_request *req)
 		/* NB request buffers use an embedded
 		 * req if the incoming req unlinked the
 		 * MD; this isn't one of them! */
-		ptlrpc_request_cache_free(req);
+		ptlrpc_srv_req_recycle(req->rq_rqbd->rqbd_svcpt, req);
 	}
 }
 
@@ -947,7 +1012,8 @@ void ptlrpc_server_drop_request(struct ptlrpc_request *req)
 		}
 
 		spin_unlock(&svcpt->scp_lock);
-	} else if (req->rq_reply_state && req->rq_reply_state->rs_prealloc) {
+	} else if (req->rq_reply_state && req->rq_reply_state->rs_prealloc &&
+		   !req->rq_reply_state->rs_recycle) {
 		/* If we are low on memory, we are not interested in history */
 		list_del(&req->rq_list);
 		list_del_init(&req->rq_history_list);
@@ -1786,13 +1852,30 @@ ptlrpc_server_request_pending(struct ptlrpc_service_part *svcpt, bool force)
 	       ptlrpc_server_normal_pending(svcpt, force);
 }
 
+/**
+ * Whether the next request of the regular or high-priority NRS head of
+ * \a svcpt has opcode \a opc, i.e. can be handled in the same batch as the
+ * request the calling thread has just handled.
+ * Must be called with ptlrpc_service_part::scp_req_lock held
+ */
+static bool ptlrpc_server_req_batchable(struct ptlrpc_service_part *svcpt,
+					bool hp, __u32 opc)
+{
+	struct ptlrpc_request *req = ptlrpc_nrs_req_peek_nolock(svcpt, hp);
+
+	return req != NULL && lustre_msg_get_opc(req->rq_reqmsg) == opc;
+}
+
 /**
  * Fetch a request for processing from queue of unprocessed requests.
  * Favors high-priority requests.
+ * If \a batch is set, only a request with opcode \a opc is returned, and
+ * only if it is the one that would have been fetched anyway.
  * Returns a pointer to fetched request.
  */
 static struct ptlrpc_request *
-ptlrpc_server_request_get(struct ptlrpc_service_part *svcpt, bool force)
+ptlrpc_server_request_get0(struct ptlrpc_service_part *svcpt, bool force,
+			   bool batch, __u32 opc)
 {
 	struct ptlrpc_request *req = NULL;
 	ENTRY;
@@ -1800,6 +1883,9 @@ ptlrpc_server_request_get(struct ptlrpc_service_part *svcpt, bool force)
 	spin_lock(&svcpt->scp_req_lock);
 
 	if (ptlrpc_server_high_pending(svcpt, force)) {
+		if (batch && !ptlrpc_server_req_batchable(svcpt, true, opc))
+			goto out_unlock;
+
 		req = ptlrpc_nrs_req_get_nolock(svcpt, true, force);
 		if (req != NULL) {
 			svcpt->scp_hreq_count++;
@@ -1808,6 +1894,9 @@ ptlrpc_server_request_get(struct ptlrpc_service_part *svcpt, bool force)
 	}
 
 	if (ptlrpc_server_normal_pending(svcpt, force)) {
+		if (batch && !ptlrpc_server_req_batchable(svcpt, false, opc))
+			goto out_unlock;
+
 		req = ptlrpc_nrs_req_get_nolock(svcpt, false, force);
 		if (req != NULL) {
 			svcpt->scp_hreq_count = 0;
@@ -1815,6 +1904,7 @@ ptlrpc_server_request_get(struct ptlrpc_service_part *svcpt, bool force)
 		}
 	}
 
+out_unlock:
 	spin_unlock(&svcpt->scp_req_lock);
 	RETURN(NULL);
 
@@ -1823,6 +1913,16 @@ got_request:
 	if (req->rq_hp)
 		svcpt->scp_nhreqs_active++;
 
+	if (!force) {
+		struct timeval	now;
+		long		qwait;
+
+		do_gettimeofday(&now);
+		qwait = cfs_timeval_sub(&now, &req->rq_arrival_time, NULL);
+		/* weight 1/8, as for the TCP RTT estimate */
+		svcpt->scp_qwait_avg += (qwait - svcpt->scp_qwait_avg) / 8;
+	}
+
 	spin_unlock(&svcpt->scp_req_lock);
 
 	if (likely(req->rq_export))
@@ -1831,6 +1931,12 @@ got_request:
 	RETURN(req);
 }
 
+static inline struct ptlrpc_request *
+ptlrpc_server_request_get(struct ptlrpc_service_part *svcpt, bool force)
+{
+	return ptlrpc_server_request_get0(svcpt, force, false, 0);
+}
+
 /**
  * Handle freshly incoming reqs, add to timed early reply list,
  * pass on to regular request queue.
@@ -1998,10 +2104,13 @@ err_req:
 /**
  * Main incoming request handling logic.
  * Calls handler function from service to do actual processing.
+ * If \a batch is set, only a request with opcode \a *opc is handled; the
+ * opcode of the handled request is returned in \a *opc.
  */
 static int
 ptlrpc_server_handle_request(struct ptlrpc_service_part *svcpt,
-			     struct ptlrpc_thread *thread)
+			     struct ptlrpc_thread *thread,
+			     bool batch, __u32 *opc)
 {
 	struct ptlrpc_service	*svc = svcpt->scp_service;
 	struct ptlrpc_request	*request;
@@ -2012,10 +2121,12 @@ ptlrpc_server_handle_request(struct ptlrpc_service_part *svcpt,
 
 	ENTRY;
 
-	request = ptlrpc_server_request_get(svcpt, false);
+	request = ptlrpc_server_request_get0(svcpt, false, batch, *opc);
 	if (request == NULL)
 		RETURN(0);
 
+	*opc = lustre_msg_get_opc(request->rq_reqmsg);
+
         if (OBD_FAIL_CHECK(OBD_FAIL_PTLRPC_HPREQ_NOTIMEOUT))
                 fail_opc = OBD_FAIL_PTLRPC_HPREQ_NOTIMEOUT;
         else if (OBD_FAIL_CHECK(OBD_FAIL_PTLRPC_HPREQ_TIMEOUT))
@@ -2132,6 +2243,20 @@ put_conn:
                                             timediff);
                 }
         }
+	if (likely(svc->srv_latency_hist != NULL &&
+		   request->rq_reqmsg != NULL)) {
+		int opc = opcode_offset(lustre_msg_get_opc(request->rq_reqmsg));
+
+		if (opc >= 0 && opc < LUSTRE_MAX_OPCODES) {
+			lprocfs_hist_tally_log2(svc->srv_latency_hist, opc,
+				PTLRPC_LAT_QUEUE_WAIT,
+				cfs_timeval_sub(&work_start,
+						&request->rq_arrival_time,
+						NULL));
+			lprocfs_hist_tally_log2(svc->srv_latency_hist, opc,
+						PTLRPC_LAT_SERVICE, timediff);
+		}
+	}
         if (unlikely(request->rq_early_count)) {
                 DEBUG_REQ(D_ADAPTTO, request,
                           "sent %d early replies before finishing in "
@@ -2167,7 +2292,7 @@ ptlrpc_handle_rs(struct ptlrpc_reply_state *rs)
 
 	spin_lock(&exp->exp_lock);
 	/* Noop if removed already */
-	list_del_init(&rs->rs_exp_list);
+	ptlrpc_rs_exp_del(rs);
 	spin_unlock(&exp->exp_lock);
 
         /* The disk commit callback holds exp_uncommitted_replies_lock while it
@@ -2292,6 +2417,34 @@ ptlrpc_threads_enough(struct ptlrpc_service_part *svcpt)
 	       (svcpt->scp_service->srv_ops.so_hpreq_handler != NULL);
 }
 
+/**
+ * requests wait too long in the NRS heads while they could be served
+ * user can call it w/o any lock but need to hold
+ * ptlrpc_service_part::scp_req_lock to get reliable result
+ */
+static inline int
+ptlrpc_threads_slow(struct ptlrpc_service_part *svcpt)
+{
+	int target = svcpt->scp_service->srv_qwait_target;
+
+	return target > 0 && svcpt->scp_qwait_avg > target &&
+	       ptlrpc_server_request_pending(svcpt, false);
+}
+
+/**
+ * idle threads are allowed to exit
+ * user can call it w/o any lock but need to hold
+ * ptlrpc_service_part::scp_lock to get reliable result
+ */
+static inline int
+ptlrpc_threads_shrinkable(struct ptlrpc_service_part *svcpt)
+{
+	struct ptlrpc_service *svc = svcpt->scp_service;
+
+	return svc->srv_qwait_target > 0 &&
+	       svcpt->scp_nthrs_running > svc->srv_nthrs_cpt_init;
+}
+
 /**
  * allowed to create more threads
  * user can call it w/o any lock but need to hold
@@ -2311,7 +2464,7 @@ ptlrpc_threads_increasable(struct ptlrpc_service_part *svcpt)
 static inline int
 ptlrpc_threads_need_create(struct ptlrpc_service_part *svcpt)
 {
-	return !ptlrpc_threads_enough(svcpt) &&
+	return (!ptlrpc_threads_enough(svcpt) || ptlrpc_threads_slow(svcpt)) &&
 		ptlrpc_threads_increasable(svcpt);
 }
 
@@ -2346,6 +2499,85 @@ ptlrpc_server_request_incoming(struct ptlrpc_service_part *svcpt)
 	return !list_empty(&svcpt->scp_req_incoming);
 }
 
+/**
+ * Handles pending requests back to back, for as long as the next request
+ * has the same opcode as the previous one, up to
+ * ptlrpc_service::srv_batch_max requests; this saves a pass through the
+ * event loop of ptlrpc_main() per request during metadata storms.
+ *
+ * The thread context is still entered and exited for every request, as
+ * some context keys reset per-request state in their lu_context_key::lct_exit
+ * method.
+ */
+static void
+ptlrpc_server_handle_requests(struct ptlrpc_service_part *svcpt,
+			      struct ptlrpc_thread *thread)
+{
+	struct lu_env	*env = thread->t_env;
+	int		 batch_max = ACCESS_ONCE(svcpt->scp_service->srv_batch_max);
+	__u32		 opc = 0;
+	int		 count = 0;
+	int		 rc;
+
+	while (1) {
+		lu_context_enter(&env->le_ctx);
+		rc = ptlrpc_server_handle_request(svcpt, thread, count > 0,
+						  &opc);
+		lu_context_exit(&env->le_ctx);
+
+		if (rc == 0 || ++count >= batch_max ||
+		    ptlrpc_thread_stopping(thread))
+			break;
+
+		/* reset le_ses to initial state */
+		env->le_ses = NULL;
+		lc_watchdog_touch(thread->t_watchdog,
+				  ptlrpc_server_get_timeout(svcpt));
+		cond_resched();
+	}
+}
+
+/**
+ * Lets service thread \a thread exit after it has been idle for
+ * PTLRPC_THR_IDLE_TIMEOUT seconds, unless that would leave the partition with
+ * fewer than ptlrpc_service::srv_nthrs_cpt_init threads, or work has shown up
+ * meanwhile. The thread stops counting as running immediately, so that idle
+ * threads cannot all retire at once.
+ *
+ * \retval true the thread should exit
+ */
+static bool
+ptlrpc_thread_retire(struct ptlrpc_service_part *svcpt,
+		     struct ptlrpc_thread *thread)
+{
+	bool retire = false;
+
+	spin_lock(&svcpt->scp_lock);
+	if (ptlrpc_threads_shrinkable(svcpt) &&
+	    !ptlrpc_thread_stopping(thread) &&
+	    !ptlrpc_server_request_incoming(svcpt) &&
+	    !ptlrpc_server_request_pending(svcpt, false) &&
+	    !ptlrpc_rqbd_pending(svcpt) &&
+	    !ptlrpc_at_check(svcpt)) {
+		thread_clear_flags(thread, SVC_RUNNING);
+		svcpt->scp_nthrs_running--;
+		retire = true;
+	}
+	spin_unlock(&svcpt->scp_lock);
+
+	if (retire)
+		CDEBUG(D_RPCTRACE, "%s: retiring idle thread %s, %d left\n",
+		       svcpt->scp_service->srv_name, thread->t_name,
+		       svcpt->scp_nthrs_running);
+
+	return retire;
+}
+
+/**
+ * \retval 0		 there may be work for the thread
+ * \retval -EINTR	 the thread should stop
+ * \retval -ETIMEDOUT the thread has been idle and has retired
+ */
 static __attribute__((__noinline__)) int
 ptlrpc_wait_event(struct ptlrpc_service_part *svcpt,
 		  struct ptlrpc_thread *thread)
@@ -2353,12 +2585,20 @@ ptlrpc_wait_event(struct ptlrpc_service_part *svcpt,
 	/* Don't exit while there are replies to be handled */
 	struct l_wait_info lwi = LWI_TIMEOUT(svcpt->scp_rqbd_timeout,
 					     ptlrpc_retry_rqbds, svcpt);
+	bool		   idle = false;
+	int		   rc;
 
 	lc_watchdog_disable(thread->t_watchdog);
 
 	cond_resched();
 
-	l_wait_event_exclusive_head(svcpt->scp_waitq,
+	if (svcpt->scp_rqbd_timeout == 0 && ptlrpc_threads_shrinkable(svcpt)) {
+		lwi = LWI_TIMEOUT(cfs_time_seconds(PTLRPC_THR_IDLE_TIMEOUT),
+				  NULL, NULL);
+		idle = true;
+	}
+
+	rc = l_wait_event_exclusive_head(svcpt->scp_waitq,
 				ptlrpc_thread_stopping(thread) ||
 				ptlrpc_server_request_incoming(svcpt) ||
 				ptlrpc_server_request_pending(svcpt, false) ||
@@ -2368,6 +2608,9 @@ ptlrpc_wait_event(struct ptlrpc_service_part *svcpt,
 	if (ptlrpc_thread_stopping(thread))
 		return -EINTR;
 
+	if (rc == -ETIMEDOUT && idle && ptlrpc_thread_retire(svcpt, thread))
+		return -ETIMEDOUT;
+
 	lc_watchdog_touch(thread->t_watchdog,
 			  ptlrpc_server_get_timeout(svcpt));
 	return 0;
@@ -2388,6 +2631,7 @@ static int ptlrpc_main(void *arg)
 	struct group_info *ginfo = NULL;
 	struct lu_env *env;
 	int counter = 0, rc = 0;
+	bool retired = false;
 	ENTRY;
 
 	thread->t_pid = current_pid();
@@ -2481,8 +2725,12 @@ static int ptlrpc_main(void *arg)
 
 	/* XXX maintain a list of all managed devices: insert here */
 	while (!ptlrpc_thread_stopping(thread)) {
-		if (ptlrpc_wait_event(svcpt, thread))
+		rc = ptlrpc_wait_event(svcpt, thread);
+		if (rc != 0) {
+			retired = rc == -ETIMEDOUT;
+			rc = 0;
 			break;
+		}
 
 		ptlrpc_check_rqbd_pool(svcpt);
 
@@ -2508,11 +2756,8 @@ static int ptlrpc_main(void *arg)
 		if (ptlrpc_at_check(svcpt))
 			ptlrpc_at_check_timed(svcpt);
 
-		if (ptlrpc_server_request_pending(svcpt, false)) {
-			lu_context_enter(&env->le_ctx);
-			ptlrpc_server_handle_request(svcpt, thread);
-			lu_context_exit(&env->le_ctx);
-                }
+		if (ptlrpc_server_request_pending(svcpt, false))
+			ptlrpc_server_handle_requests(svcpt, thread);
 
 		if (ptlrpc_rqbd_pending(svcpt) &&
 		    ptlrpc_server_post_idle_rqbds(svcpt) < 0) {
@@ -2528,6 +2773,22 @@ static int ptlrpc_main(void *arg)
         lc_watchdog_delete(thread->t_watchdog);
         thread->t_watchdog = NULL;
 
+	if (retired) {
+		/* give back the reply state this thread added to the pool */
+		spin_lock(&svcpt->scp_rep_lock);
+		if (!list_empty(&svcpt->scp_rep_idle)) {
+			rs = list_entry(svcpt->scp_rep_idle.next,
+					struct ptlrpc_reply_state, rs_list);
+			list_del(&rs->rs_list);
+		} else {
+			rs = NULL;
+		}
+		spin_unlock(&svcpt->scp_rep_lock);
+
+		if (rs != NULL)
+			OBD_FREE_LARGE(rs, svc->srv_max_reply_size);
+	}
+
 out_srv_fini:
         /*
          * deconstruct service specific state created by ptlrpc_start_thread()
@@ -2552,6 +2813,16 @@ out:
 		svcpt->scp_nthrs_running--;
 	}
 
+	if (retired && !thread_is_stopping(thread)) {
+		/* nobody is waiting for a retired thread, so it can release
+		 * its descriptor itself, unless ptlrpc_svcpt_stop_threads()
+		 * has found it meanwhile */
+		list_del(&thread->t_link);
+		spin_unlock(&svcpt->scp_lock);
+		OBD_FREE_PTR(thread);
+		return 0;
+	}
+
 	thread->t_id = rc;
 	thread_add_flags(thread, SVC_STOPPED);
 
@@ -3119,6 +3390,22 @@ ptlrpc_service_purge_all(struct ptlrpc_service *svc)
 			list_del(&rs->rs_list);
 			OBD_FREE_LARGE(rs, svc->srv_max_reply_size);
 		}
+
+		while (!list_empty(&svcpt->scp_rep_free)) {
+			rs = list_entry(svcpt->scp_rep_free.next,
+					struct ptlrpc_reply_state, rs_list);
+			list_del(&rs->rs_list);
+			svcpt->scp_nreps_free--;
+			OBD_FREE_LARGE(rs, svc->srv_rs_recycle_size);
+		}
+
+		while (!list_empty(&svcpt->scp_req_free)) {
+			req = list_entry(svcpt->scp_req_free.next,
+					 struct ptlrpc_request, rq_list);
+			list_del(&req->rq_list);
+			svcpt->scp_nreqs_free--;
+			ptlrpc_request_cache_free(req);
+		}
 	}
 }
 
@@ -1179,6 +1179,10 @@ void lustre_assert_wire_constants(void)
 		 OBD_CONNECT_UNLINK_CLOSE);
 	LASSERTF(OBD_CONNECT_DIR_STRIPE == 0x400000000000000ULL, "found 0x%.16llxULL\n",
 		 OBD_CONNECT_DIR_STRIPE);
+	LASSERTF(OBD_CONNECT_LOCKAHEAD == 0x1000000000000000ULL, "found 0x%.16llxULL\n",
+		 OBD_CONNECT_LOCKAHEAD);
+	LASSERTF(OBD_CONNECT_BL_BATCH == 0x2000000000000000ULL, "found 0x%.16llxULL\n",
+		 OBD_CONNECT_BL_BATCH);
 	LASSERTF(OBD_CKSUM_CRC32 == 0x00000001UL, "found 0x%.8xUL\n",
 		(unsigned)OBD_CKSUM_CRC32);
 	LASSERTF(OBD_CKSUM_ADLER == 0x00000002UL, "found 0x%.8xUL\n",
@@ -327,8 +327,7 @@ static int it_test_search_hole(struct interval_node *root)
                         high = min_u64(n->node.in_extent.start - 1, high);
         }
 
-        /* only expanding high right now */
-        if (ext2.start != ext.start || high != ext.end) {
+        if (low != ext.start || high != ext.end) {
                 ext2.start = low, ext2.end = high;
                 error("Real extending result:"__S", expected:"__S"\n",
                        __F(&ext), __F(&ext2));
@@ -0,0 +1,109 @@
+/*
+ * GPL HEADER START
+ *
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 only,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License version 2 for more details (a copy is included
+ * in the LICENSE file that accompanied this code).
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; If not, see
+ * http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * GPL HEADER END
+ */
+/*
+ * Requests lock ahead locks on extents of a file with llapi_lock_ahead():
+ *
+ *  lockahead_test <file> {r|w} <start> <end> [<start> <end> ...]
+ *
+ * Prints the result of each extent. Exits with 0 if every lock was granted,
+ * with the errno of the ioctl if it failed, e.g. EOPNOTSUPP, and with 1 if
+ * any extent was not granted.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <lustre/lustreapi.h>
+
+static void usage(char *prog)
+{
+	fprintf(stderr, "usage: %s <file> {r|w} <start> <end> "
+		"[<start> <end> ...]\n", prog);
+	exit(EINVAL);
+}
+
+int main(int argc, char *argv[])
+{
+	struct llapi_lock_ahead_arg	*lla;
+	int				 count;
+	int				 fd;
+	int				 rc;
+	int				 i;
+
+	if (argc < 5 || (argc - 3) % 2 != 0)
+		usage(argv[0]);
+
+	count = (argc - 3) / 2;
+	lla = calloc(1, sizeof(*lla) + count * sizeof(lla->lla_extents[0]));
+	if (lla == NULL) {
+		fprintf(stderr, "cannot allocate %d extents\n", count);
+		return ENOMEM;
+	}
+
+	lla->lla_version = LLAPI_LOCK_AHEAD_V1;
+	lla->lla_extent_count = count;
+	if (strcmp(argv[2], "r") == 0)
+		lla->lla_lock_mode = LLAPI_LOCK_MODE_READ;
+	else if (strcmp(argv[2], "w") == 0)
+		lla->lla_lock_mode = LLAPI_LOCK_MODE_WRITE;
+	else
+		usage(argv[0]);
+
+	for (i = 0; i < count; i++) {
+		lla->lla_extents[i].lle_start = strtoull(argv[3 + 2 * i],
+							 NULL, 0);
+		lla->lla_extents[i].lle_end = strtoull(argv[4 + 2 * i],
+						       NULL, 0);
+	}
+
+	fd = open(argv[1], O_RDWR | O_CREAT, 0644);
+	if (fd < 0) {
+		rc = errno;
+		fprintf(stderr, "cannot open %s: %s\n", argv[1], strerror(rc));
+		free(lla);
+		return rc;
+	}
+
+	rc = llapi_lock_ahead(fd, lla);
+	if (rc < 0) {
+		fprintf(stderr, "lock ahead on %s failed: %s\n", argv[1],
+			strerror(-rc));
+		rc = -rc;
+		goto out;
+	}
+
+	for (i = 0; i < count; i++) {
+		printf("[%llu, %llu]: %d\n",
+		       (unsigned long long)lla->lla_extents[i].lle_start,
+		       (unsigned long long)lla->lla_extents[i].lle_end,
+		       lla->lla_extents[i].lle_result);
+		if (lla->lla_extents[i].lle_result != 0)
+			rc = 1;
+	}
+out:
+	close(fd);
+	free(lla);
+	return rc;
+}
@@ -0,0 +1,134 @@
+/*
+ * GPL HEADER START
+ *
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 only,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License version 2 for more details (a copy is included
+ * in the LICENSE file that accompanied this code).
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; If not, see
+ * http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * GPL HEADER END
+ */
+/*
+ * Reads disjoint regions of a file sequentially from two processes sharing
+ * one file descriptor, so that both read streams go through the same
+ * struct file:
+ *
+ *  ra_streams_test <file> <offset1> <offset2> <length> <blocksize>
+ *
+ * The parent reads <length> bytes from <offset1>, the child from <offset2>,
+ * both with pread() so that the shared file position does not matter.
+ * Exits with 0 if both regions were read completely.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+static void usage(char *prog)
+{
+	fprintf(stderr, "usage: %s <file> <offset1> <offset2> <length> "
+		"<blocksize>\n", prog);
+	exit(EINVAL);
+}
+
+static int read_region(int fd, off_t offset, off_t length, size_t bs)
+{
+	char	*buf;
+	off_t	 pos;
+	ssize_t	 rc;
+
+	buf = malloc(bs);
+	if (buf == NULL) {
+		fprintf(stderr, "cannot allocate %zu bytes\n", bs);
+		return ENOMEM;
+	}
+
+	for (pos = offset; pos < offset + length; pos += rc) {
+		rc = pread(fd, buf, bs, pos);
+		if (rc <= 0) {
+			rc = rc < 0 ? errno : EIO;
+			fprintf(stderr, "read at %llu failed: %s\n",
+				(unsigned long long)pos, strerror(rc));
+			free(buf);
+			return rc;
+		}
+	}
+
+	free(buf);
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	off_t	offset1;
+	off_t	offset2;
+	off_t	length;
+	size_t	bs;
+	pid_t	pid;
+	int	status;
+	int	fd;
+	int	rc;
+
+	if (argc != 6)
+		usage(argv[0]);
+
+	offset1 = strtoull(argv[2], NULL, 0);
+	offset2 = strtoull(argv[3], NULL, 0);
+	length = strtoull(argv[4], NULL, 0);
+	bs = strtoul(argv[5], NULL, 0);
+	if (bs == 0)
+		usage(argv[0]);
+
+	fd = open(argv[1], O_RDONLY);
+	if (fd < 0) {
+		rc = errno;
+		fprintf(stderr, "cannot open %s: %s\n", argv[1], strerror(rc));
+		return rc;
+	}
+
+	pid = fork();
+	if (pid < 0) {
+		rc = errno;
+		fprintf(stderr, "cannot fork: %s\n", strerror(rc));
+		close(fd);
+		return rc;
+	}
+
+	if (pid == 0)
+		exit(read_region(fd, offset2, length, bs));
+
+	rc = read_region(fd, offset1, length, bs);
+
+	if (waitpid(pid, &status, 0) < 0) {
+		int err = errno;
+
+		fprintf(stderr, "cannot wait for %d: %s\n", pid,
+			strerror(err));
+		if (rc == 0)
+			rc = err;
+	} else if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+		fprintf(stderr, "reader of offset %llu failed\n",
+			(unsigned long long)offset2);
+		if (rc == 0)
+			rc = 1;
+	}
+
+	close(fd);
+	return rc;
+}
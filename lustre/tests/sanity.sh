@@ -8334,6 +8334,104 @@ test_124b() {
 }
 run_test 124b "lru resize (performance test) ======================="
 
+test_124c() {
+	[ $PARALLEL == "yes" ] && skip "skip parallel run" && return
+	[ -z "$($LCTL get_param -n ldlm.namespaces.*mdc*.lru_reuse_max)" ] &&
+		skip "no lru_reuse_max on client" && return 0
+
+	local lru=200
+	local hot=20
+	local cold=$((lru * 4))
+	local i
+
+	test_mkdir -p $DIR/$tdir/hot || error "mkdir $DIR/$tdir/hot failed"
+	test_mkdir -p $DIR/$tdir/cold || error "mkdir $DIR/$tdir/cold failed"
+	createmany -o $DIR/$tdir/hot/f $hot ||
+		error "failed to create $hot files in $DIR/$tdir/hot"
+	createmany -o $DIR/$tdir/cold/f $cold ||
+		error "failed to create $cold files in $DIR/$tdir/cold"
+
+	cancel_lru_locks mdc
+	$LCTL set_param -n ldlm.namespaces.*mdc*.lru_size=$lru
+
+	# the working set is used again some time after its locks went to
+	# the LRU, so that each pass counts as a reuse
+	for i in 1 2 3; do
+		stat $DIR/$tdir/hot/f* > /dev/null ||
+			error "stat $DIR/$tdir/hot failed"
+		sleep 3
+	done
+
+	# a single pass over much more files than the LRU can hold
+	stat $DIR/$tdir/cold/f* > /dev/null || error "stat $DIR/$tdir/cold failed"
+
+	$LCTL set_param -n mdc.*.stats clear
+	stat $DIR/$tdir/hot/f* > /dev/null || error "stat $DIR/$tdir/hot failed"
+	local enq=$($LCTL get_param -n mdc.*.stats |
+		    awk '/^ldlm_ibits_enqueue/ { sum += $2 } END { print sum + 0 }')
+	log "$enq enqueues to stat the $hot working set files again"
+
+	if [ -n "$($LCTL get_param -n mdc.*.connect_flags | grep lru_resize)" ]
+	then
+		lru_resize_enable mdc
+	else
+		lru_resize_disable mdc
+	fi
+
+	[ $enq -le $((hot / 2)) ] ||
+		error "scan pushed out the working set: $enq enqueues for $hot files"
+
+	unlinkmany $DIR/$tdir/cold/f $cold
+	unlinkmany $DIR/$tdir/hot/f $hot
+}
+run_test 124c "one-pass scan keeps reused locks in the LRU ======"
+
+test_124d() {
+	[ $PARALLEL == "yes" ] && skip "skip parallel run" && return
+	remote_mds_nodsh && skip "remote MDS with nodsh" && return
+	local ns=ldlm.namespaces.mdt-$FSNAME-MDT0000*.pool
+	if ! do_facet mds1 $LCTL get_param -n $ns.mem_aware > /dev/null 2>&1
+	then
+		skip "no mem_aware on server"
+		return 0
+	fi
+
+	local nr=500
+	local old=$(do_facet mds1 $LCTL get_param -n $ns.mem_aware)
+	local gm0
+	local gm1
+	local slv
+
+	test_mkdir -p $DIR/$tdir || error "failed to create $DIR/$tdir"
+	createmany -o $DIR/$tdir/f $nr ||
+		error "failed to create $nr files in $DIR/$tdir"
+	cancel_lru_locks mdc
+
+	do_facet mds1 $LCTL set_param -n $ns.mem_aware=1
+	gm0=$(do_facet mds1 $LCTL get_param -n $ns.state |
+	      awk '/GM:/ { print $2 }')
+	ls -l $DIR/$tdir > /dev/null || error "ls -l $DIR/$tdir failed"
+	gm1=$(do_facet mds1 $LCTL get_param -n $ns.state |
+	      awk '/GM:/ { print $2 }')
+	log "granted memory $gm0 -> $gm1 bytes for $nr files"
+
+	# let the pool recalculate SLV against the memory in use
+	sleep $(do_facet mds1 $LCTL get_param -n $ns.recalc_period)
+	sleep 1
+	slv=$(do_facet mds1 $LCTL get_param -n $ns.server_lock_volume)
+
+	cancel_lru_locks mdc
+	do_facet mds1 $LCTL set_param -n $ns.mem_aware=$old
+	unlinkmany $DIR/$tdir/f $nr
+
+	# each file pins at least a lock and its resource
+	[ $((gm1 - gm0)) -ge $((nr * 512)) ] ||
+		error "granted memory grew by $((gm1 - gm0)) for $nr files"
+	# page cache is reclaimable, so SLV must not collapse with it
+	[ $slv -gt 1 ] || error "SLV $slv collapsed in memory-aware mode"
+}
+run_test 124d "memory-aware server pool accounts granted lock memory"
+
 test_125() { # 13358
 	[ -z "$(lctl get_param -n llite.*.client_type | grep local)" ] && skip "must run as local client" && return
 	[ -z "$(lctl get_param -n mdc.*-mdc-*.connect_flags | grep acl)" ] && skip "must have acl enabled" && return
@@ -12818,6 +12916,142 @@ test_242() {
 }
 run_test 242 "mdt_readpage failure should not cause directory unreadable"
 
+test_243() {
+	which lockahead_test > /dev/null || {
+		skip_env "no lockahead_test" && return; }
+
+	local osc=$($LCTL dl | awk '/-osc-/ && /OST0000/ { print $4; exit }')
+	local enq
+
+	$LFS setstripe -c 1 -i 0 $DIR/$tfile || error "setstripe failed"
+	cancel_lru_locks osc
+
+	if [ -z "$($LCTL get_param -n osc.$osc.connect_flags |
+		   grep lockahead)" ]; then
+		lockahead_test $DIR/$tfile w 0 1048575
+		[ $? -eq 95 ] || error "lock ahead without server support " \
+				       "did not fail with EOPNOTSUPP"
+		return 0
+	fi
+
+	lockahead_test $DIR/$tfile x 0 1048575 &&
+		error "lock ahead with a bad mode succeeded"
+	lockahead_test $DIR/$tfile w 1048575 0 &&
+		error "lock ahead with a reversed extent succeeded"
+
+	lockahead_test $DIR/$tfile w 0 1048575 4194304 5242879 ||
+		error "lock ahead failed"
+
+	# writes within the locked extents match the lock ahead locks, and
+	# the locks were not expanded over the rest of the file
+	$LCTL set_param -n osc.$osc.stats clear
+	dd if=/dev/zero of=$DIR/$tfile bs=1M count=1 conv=notrunc ||
+		error "dd at 0 failed"
+	dd if=/dev/zero of=$DIR/$tfile bs=1M count=1 seek=4 conv=notrunc ||
+		error "dd at 4M failed"
+	enq=$($LCTL get_param -n osc.$osc.stats |
+	      awk '/^ldlm_extent_enqueue/ { print $2 }')
+	[ -z "$enq" ] || error "$enq enqueues for locked extents"
+
+	dd if=/dev/zero of=$DIR/$tfile bs=1M count=1 seek=8 conv=notrunc ||
+		error "dd at 8M failed"
+	enq=$($LCTL get_param -n osc.$osc.stats |
+	      awk '/^ldlm_extent_enqueue/ { print $2 }')
+	[ "$enq" = "1" ] || error "lock ahead lock was expanded"
+
+	rm -f $DIR/$tfile
+}
+run_test 243 "lock ahead ioctl requests exactly the given extents"
+
+test_244() {
+	[ -z "$($LCTL get_param -n llite.*.fast_read 2>/dev/null)" ] &&
+		skip "no fast_read support" && return
+
+	local old=$($LCTL get_param -n llite.*.fast_read | head -n1)
+	local sum0
+	local sum1
+	local hits
+
+	dd if=/dev/urandom of=$DIR/$tfile bs=1M count=4 || error "dd failed"
+	sum0=$(md5sum < $DIR/$tfile)
+
+	# through CLIO, with the pages cached from the write
+	$LCTL set_param -n llite.*.fast_read=0
+	sum1=$(md5sum < $DIR/$tfile)
+	[ "$sum0" = "$sum1" ] || error "data differs with fast_read=0"
+
+	# from the page cache, bypassing CLIO, with read-ahead accounting
+	$LCTL set_param -n llite.*.fast_read=1
+	$LCTL set_param -n llite.*.read_ahead_stats 0
+	sum1=$(md5sum < $DIR/$tfile)
+	[ "$sum0" = "$sum1" ] || error "data differs with fast_read=1"
+	hits=$($LCTL get_param -n llite.*.read_ahead_stats |
+	       awk '/^hits/ { sum += $2 } END { print sum + 0 }')
+	[ $hits -ge 1024 ] ||
+		error "fast reads of 1024 cached pages counted $hits hits"
+
+	# once the pages are dropped with the lock, the read goes to CLIO
+	cancel_lru_locks osc
+	sum1=$(md5sum < $DIR/$tfile)
+	[ "$sum0" = "$sum1" ] || error "data differs after lock cancel"
+
+	$LCTL set_param -n llite.*.fast_read=$old
+	rm -f $DIR/$tfile
+}
+run_test 244 "fast_read returns the same data as reads through CLIO"
+
+test_245() {
+	which ra_streams_test > /dev/null || {
+		skip_env "no ra_streams_test" && return; }
+
+	local async=$($LCTL get_param -n llite.*.max_read_ahead_async_active |
+		      head -n1)
+	local stats
+	local count
+
+	# the regions are further apart than any read-ahead window, so the
+	# second reader cannot be taken for the first one
+	$LFS setstripe -c 1 -i 0 $DIR/$tfile || error "setstripe failed"
+	dd if=/dev/zero of=$DIR/$tfile bs=1M count=16 || error "dd at 0 failed"
+	dd if=/dev/zero of=$DIR/$tfile bs=1M count=16 seek=256 conv=notrunc ||
+		error "dd at 256M failed"
+	cancel_lru_locks osc
+
+	$LCTL set_param -n llite.*.max_read_ahead_async_active=4
+	$LCTL set_param -n llite.*.read_ahead_stats 0
+	ra_streams_test $DIR/$tfile 0 $((256 << 20)) $((16 << 20)) 1048576 ||
+		error "ra_streams_test failed"
+	$LCTL set_param -n llite.*.max_read_ahead_async_active=$async
+
+	stats=$($LCTL get_param -n llite.*.read_ahead_stats)
+	echo "$stats"
+
+	# the first stream of a file descriptor exists from open on
+	count=$(echo "$stats" | awk '/^new stream/ { print $3 }')
+	[ "$count" = "1" ] || error "$count new streams, expected 1"
+
+	count=$(echo "$stats" | awk '/^async readahead/ { print $3 }')
+	[ -n "$count" ] || error "no asynchronous read-ahead"
+
+	# both streams are reported at close, each with read-ahead hits
+	count=$(echo "$stats" | awk '/^stream hits/ { print $3 }')
+	[ "$count" = "2" ] || error "hits reported for $count streams"
+	count=$(echo "$stats" | awk '/^stream hits/ { print $6 }')
+	[ $count -gt 0 ] || error "a stream had $count read-ahead hits"
+
+	# only the start of the second stream is not consecutive, neither
+	# reader reset the window of the other
+	count=$(echo "$stats" |
+		awk '/^readpage not consecutive/ { print $4 }')
+	[ "$count" = "1" ] ||
+		error "$count non-consecutive reads, windows were reset"
+	count=$(echo "$stats" | awk '/^miss inside window/ { print $4 }')
+	[ -z "$count" ] || error "$count misses inside the read-ahead window"
+
+	rm -f $DIR/$tfile
+}
+run_test 245 "two readers of one file descriptor keep separate windows"
+
 cleanup_test_300() {
 	trap 0
 	umask $SAVE_UMASK
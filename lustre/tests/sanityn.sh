@@ -2808,6 +2808,110 @@ test_76() { #LU-946
 }
 run_test 76 "Verify open file for 2048 files"
 
+test_77a() {
+	remote_ost_nodsh && skip "remote OST with nodsh" && return
+
+	local nid=$($LCTL list_nids | head -n1)
+	local nodes=$(comma_list $(osts_nodes))
+	local parent_rate=20
+	local child_rate=5
+	local count=100
+	local borrowed
+
+	do_nodes $nodes $LCTL set_param ost.OSS.ost_io.nrs_policies="tbf\ nid"
+	[ $? -ne 0 ] && error "failed to set TBF NID policy"
+
+	# the child is the newer rule, so it matches the client; it may run
+	# above its own rate only on what the parent leaves unused
+	do_nodes $nodes $LCTL set_param ost.OSS.ost_io.nrs_tbf_rule=\
+"start\ tbf_parent\ {$nid}\ $parent_rate" ||
+		error "failed to start parent rule"
+	do_nodes $nodes $LCTL set_param ost.OSS.ost_io.nrs_tbf_rule=\
+"start\ tbf_child\ {$nid}\ $child_rate\ parent=tbf_parent" ||
+		error "failed to start child rule"
+	do_nodes $nodes $LCTL set_param ost.OSS.ost_io.nrs_tbf_rule=\
+"stop\ tbf_parent" && error "stopped parent with a started child"
+
+	$LFS setstripe -c 1 -i 0 $DIR1/$tfile
+	local start=$SECONDS
+	dd if=/dev/zero of=$DIR1/$tfile bs=1M count=$count oflag=direct ||
+		error "dd failed"
+	local elapsed=$((SECONDS - start))
+	echo "$count RPCs in $elapsed seconds"
+	do_facet ost1 $LCTL get_param -n ost.OSS.ost_io.nrs_tbf_rule |
+		grep tbf_child
+	# the tokens taken from the class bucket of the parent, over all CPTs
+	borrowed=$(do_facet ost1 $LCTL get_param -n \
+		ost.OSS.ost_io.nrs_tbf_rule |
+		awk '/tbf_child/ && /borrowed/ { sum += $NF }
+		     END { print sum + 0 }')
+
+	do_nodes $nodes $LCTL set_param ost.OSS.ost_io.nrs_tbf_rule=\
+"stop\ tbf_child"
+	do_nodes $nodes $LCTL set_param ost.OSS.ost_io.nrs_tbf_rule=\
+"stop\ tbf_parent"
+	do_nodes $nodes $LCTL set_param ost.OSS.ost_io.nrs_policies="fifo"
+	rm -f $DIR1/$tfile
+
+	# allow for the initial tokens in the client and class buckets
+	[ $elapsed -ge $(((count - 2 * parent_rate) / parent_rate)) ] ||
+		error "child rule ran faster than its parent rate $parent_rate"
+	# at its own rate alone the child would need $((count / child_rate))s
+	[ $elapsed -lt $((count / child_rate / 2)) ] ||
+		error "child rule did not borrow, $count RPCs in ${elapsed}s"
+	# most RPCs must have gone out on tokens of the parent
+	[ $borrowed -ge $((count / 2)) ] ||
+		error "child rule borrowed only $borrowed of $count tokens"
+}
+run_test 77a "NRS TBF child rule is limited by its parent rule"
+
+test_77b() {
+	remote_ost_nodsh && skip "remote OST with nodsh" && return
+
+	local nodes=$(comma_list $(osts_nodes))
+	local quantum
+
+	do_nodes $nodes $LCTL set_param ost.OSS.ost_io.nrs_policies="drr" ||
+		error "failed to set DRR policy"
+	# a small quantum, so that a 1MB write needs many rounds
+	do_nodes $nodes $LCTL set_param ost.OSS.ost_io.nrs_drr_quantum=64 ||
+		error "failed to set DRR quantum"
+	quantum=$(do_facet ost1 $LCTL get_param -n \
+		ost.OSS.ost_io.nrs_drr_quantum |
+		awk -F: '/reg_quantum/ { print $2 + 0 }')
+	[ "$quantum" = "64" ] || error "DRR quantum $quantum != 64"
+
+	$LFS setstripe -c 1 -i 0 $DIR1/$tfile-1
+	$LFS setstripe -c 1 -i 0 $DIR2/$tfile-2
+	local start=$(date +%s.%N)
+	(dd if=/dev/zero of=$DIR1/$tfile-1 bs=1M count=256 oflag=direct &&
+		date +%s.%N > $TMP/$tfile-1.end) &
+	local pid1=$!
+	(dd if=/dev/zero of=$DIR2/$tfile-2 bs=4k count=2048 oflag=direct &&
+		date +%s.%N > $TMP/$tfile-2.end) &
+	local pid2=$!
+	wait $pid1 || error "dd of 1MB writes failed"
+	wait $pid2 || error "dd of 4KB writes failed"
+
+	# 8MB of 4KB writes against 256MB of 1MB writes: with bandwidth
+	# shared fairly, the small writer must finish well before the large
+	# one instead of queueing behind it
+	local t1=$(awk -v s=$start '{ print $1 - s }' $TMP/$tfile-1.end)
+	local t2=$(awk -v s=$start '{ print $1 - s }' $TMP/$tfile-2.end)
+	rm -f $TMP/$tfile-1.end $TMP/$tfile-2.end
+	echo "1MB writer: ${t1}s, 4KB writer: ${t2}s"
+	awk -v a=$t2 -v b=$t1 'BEGIN { exit !(a < b) }' ||
+		error "4KB writer starved: ${t2}s vs ${t1}s for the 1MB writer"
+
+	cancel_lru_locks osc
+	cmp $DIR1/$tfile-1 $DIR2/$tfile-1 || error "$tfile-1 differs"
+	cmp $DIR1/$tfile-2 $DIR2/$tfile-2 || error "$tfile-2 differs"
+
+	do_nodes $nodes $LCTL set_param ost.OSS.ost_io.nrs_policies="fifo"
+	rm -f $DIR1/$tfile-1 $DIR1/$tfile-2
+}
+run_test 77b "NRS DRR policy with mixed RPC sizes"
+
 test_80() {
 	[ $MDSCOUNT -lt 2 ] && skip "needs >= 2 MDTs" && return
 	local MDTIDX=1
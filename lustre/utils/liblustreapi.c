@@ -4855,3 +4855,30 @@ int llapi_group_unlock(int fd, int gid)
 	}
 	return rc;
 }
+
+/**
+ * Request locks on the given extents of the file without doing any I/O.
+ *
+ * The caller fills in lla_version, lla_lock_mode, lla_extent_count and the
+ * extents; the result of each lock request is returned in lle_result.
+ * Locks are requested non-blocking, so a conflicting lock held by another
+ * client makes the matching extent fail with -EWOULDBLOCK rather than
+ * waiting for it to be cancelled.
+ *
+ * \param fd	file descriptor of a Lustre file
+ * \param lla	lock ahead request
+ *
+ * \retval 0 if the request was processed (check lle_result of each extent)
+ * \retval negative errno on failure
+ */
+int llapi_lock_ahead(int fd, struct llapi_lock_ahead_arg *lla)
+{
+	int rc;
+
+	rc = ioctl(fd, LL_IOC_LOCK_AHEAD, lla);
+	if (rc < 0) {
+		rc = -errno;
+		llapi_error(LLAPI_MSG_ERROR, rc, "cannot request lock ahead");
+	}
+	return rc;
+}